@@ -15,6 +15,7 @@ template <typename T>
 using Func = std::function<T>;
 template <typename... Ts>
 using Common = std::common_type_t<Ts...>;
+using HRClock = std::chrono::high_resolution_clock;
 
 // Smart pointer shortcuts
 template <typename T>
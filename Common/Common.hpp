@@ -1,15 +1,49 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
 #include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
 #include <memory>
+#include <mutex>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 #include <SFML/Graphics.hpp>
 #include <SFML/Window.hpp>
 #include <SFML/System.hpp>
 
 #include "../Common/Aliases.hpp"
+#include "../Common/FrameArena.hpp"
+#include "../Common/FramePacer.hpp"
+#include "../Common/Trace.hpp"
+#include "../Common/FrameProfiler.hpp"
+#include "../Common/FrameWorker.hpp"
+#include "../Common/JobSystem.hpp"
+#include "../Common/ResourceCache.hpp"
 #include "../Common/Game.hpp"
+#include "../Common/StaticGame.hpp"
 #include "../Common/NinePatch.hpp"
+#include "../Common/TileGrid.hpp"
 
 inline constexpr int get1DIndexFrom2D(int x, int y, int width)
 {
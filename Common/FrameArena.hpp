@@ -0,0 +1,116 @@
+#pragma once
+
+// Linear allocator for memory that only lives until the end of the current frame.
+// Allocating bumps an offset, deallocating does nothing, and reset() (called by the Game loop at the top of
+// every iteration) releases everything at once. When a frame needs more than the block holds, the excess is
+// served from the heap and the block grows to the high-water mark on the next reset.
+// Not thread-safe: only use it from the main thread.
+class FrameArena
+{
+public:
+    inline explicit FrameArena(std::size_t capacity = 64 * 1024)
+        : m_Block{new unsigned char[capacity]},
+          m_Capacity{capacity}
+    {
+    }
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    inline void* allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t))
+    {
+        const auto base(reinterpret_cast<std::uintptr_t>(m_Block.get()));
+        const auto aligned((base + m_Offset + alignment - 1) & ~(std::uintptr_t(alignment) - 1));
+        const auto end(aligned - base + bytes);
+
+        if (end <= m_Capacity)
+        {
+            // The padding counts too, or a block grown to the high-water mark could still come up short
+            m_FrameBytes += end - m_Offset;
+            m_Offset = end;
+            m_HighWaterMark = std::max(m_HighWaterMark, m_FrameBytes);
+            return reinterpret_cast<void*>(aligned);
+        }
+
+        // Doesn't fit: fall back to the heap for the rest of the frame
+        m_Overflow.emplace_back(new unsigned char[bytes + alignment]);
+        ++m_OverflowCount;
+        m_FrameBytes += bytes + alignment;
+        m_HighWaterMark = std::max(m_HighWaterMark, m_FrameBytes);
+
+        const auto overflowBase(reinterpret_cast<std::uintptr_t>(m_Overflow.back().get()));
+        return reinterpret_cast<void*>((overflowBase + alignment - 1) & ~(std::uintptr_t(alignment) - 1));
+    }
+
+    inline void deallocate(void*, std::size_t) noexcept { }
+
+    // Releases every allocation of the frame; everything allocated since the last reset must be dead
+    inline void reset()
+    {
+        if (!m_Overflow.empty())
+        {
+            m_Overflow.clear();
+
+            auto capacity(std::max<std::size_t>(m_Capacity, 1));
+            while (capacity < m_HighWaterMark) capacity *= 2;
+            m_Block.reset(new unsigned char[capacity]);
+            m_Capacity = capacity;
+        }
+
+        m_Offset = 0;
+        m_FrameBytes = 0;
+    }
+
+    inline std::size_t getUsed() const noexcept { return m_FrameBytes; }
+    inline std::size_t getCapacity() const noexcept { return m_Capacity; }
+    inline std::size_t getHighWaterMark() const noexcept { return m_HighWaterMark; }
+    inline std::size_t getOverflowCount() const noexcept { return m_OverflowCount; }
+
+private:
+    UPtr<unsigned char[]> m_Block;
+    std::size_t m_Capacity, m_Offset{0};
+    std::vector<UPtr<unsigned char[]>> m_Overflow;
+    std::size_t m_FrameBytes{0}, m_HighWaterMark{0}, m_OverflowCount{0};
+};
+
+// Standard allocator adaptor, so containers can live in a FrameArena
+template <typename T>
+class ArenaAllocator
+{
+public:
+    using value_type = T;
+
+    inline ArenaAllocator(FrameArena& arena) noexcept : m_Arena{&arena} { }
+
+    template <typename U>
+    inline ArenaAllocator(const ArenaAllocator<U>& other) noexcept : m_Arena{other.getArena()} { }
+
+    inline T* allocate(std::size_t n)
+    {
+        return static_cast<T*>(m_Arena->allocate(n*sizeof(T), alignof(T)));
+    }
+
+    inline void deallocate(T* p, std::size_t n) noexcept { m_Arena->deallocate(p, n*sizeof(T)); }
+
+    inline FrameArena* getArena() const noexcept { return m_Arena; }
+
+private:
+    FrameArena* m_Arena;
+};
+
+template <typename T, typename U>
+inline bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) noexcept
+{
+    return a.getArena() == b.getArena();
+}
+
+template <typename T, typename U>
+inline bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) noexcept
+{
+    return !(a == b);
+}
+
+// Per-frame container shortcuts
+template <typename T>
+using FrameVector = std::vector<T, ArenaAllocator<T>>;
+using FrameString = std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>;
\ No newline at end of file
@@ -0,0 +1,123 @@
+#pragma once
+
+enum class PacingMode
+{
+    VSync,      // Let the driver block in display() (adds up to a frame of latency)
+    Uncapped,   // No waiting at all
+    TargetRate, // Wait at the end of each frame until the target frame time has passed
+    LowLatency  // Wait at the start of each frame, as late as the predicted frame work allows, then poll input
+};
+
+// Paces the Game loop without vsync. Waits are hybrid: sleep while the remaining time is comfortably
+// above the measured sleep granularity, then spin for the rest, so the deadline is hit without burning a
+// core for the whole frame.
+class FramePacer
+{
+public:
+    inline void setMode(PacingMode mode) noexcept { m_Mode = mode; }
+    inline PacingMode getMode() const noexcept { return m_Mode; }
+
+    inline void setTargetFrameRate(float framesPerSecond) noexcept
+    {
+        m_Period = std::chrono::duration_cast<HRClock::duration>(std::chrono::duration<double>(1.0 / framesPerSecond));
+    }
+
+    inline float getTargetFrameRate() const noexcept
+    {
+        return static_cast<float>(1.0 / std::chrono::duration<double>(m_Period).count());
+    }
+
+    // Measures how much a short sleep overshoots on this machine
+    inline void calibrate()
+    {
+        m_SleepGranularity = HRClock::duration::zero();
+        for (auto i(0); i < calibrationSleeps; ++i)
+        {
+            const auto start(HRClock::now());
+            sf::sleep(sf::milliseconds(1));
+            m_SleepGranularity = std::max(m_SleepGranularity, HRClock::now() - start);
+        }
+        m_Deadline = HRClock::now() + m_Period;
+    }
+
+    inline HRClock::duration getSleepGranularity() const noexcept { return m_SleepGranularity; }
+
+    // Called before polling input; only waits in LowLatency mode. Returns the time spent waiting.
+    inline HRClock::duration beginFrame()
+    {
+        auto idle(HRClock::duration::zero());
+        if (m_Mode == PacingMode::LowLatency)
+        {
+            const auto start(HRClock::now());
+            waitUntil(m_Deadline - getPredictedWork());
+            idle = HRClock::now() - start;
+        }
+
+        m_WorkStart = HRClock::now();
+        m_LastIdle = idle;
+        return idle;
+    }
+
+    // Called after display(); only waits in TargetRate mode. Returns the time spent waiting.
+    inline HRClock::duration endFrame()
+    {
+        const auto now(HRClock::now());
+        m_Work[m_WorkHead] = now - m_WorkStart;
+        m_WorkHead = (m_WorkHead + 1) % workHistory;
+
+        auto idle(HRClock::duration::zero());
+        if (m_Mode == PacingMode::TargetRate)
+        {
+            waitUntil(m_Deadline);
+            idle = HRClock::now() - now;
+        }
+
+        // Keep a steady cadence, but don't try to make up for frames that were missed entirely
+        m_Deadline += m_Period;
+        if (m_Deadline < HRClock::now()) m_Deadline = HRClock::now() + m_Period;
+
+        m_LastIdle += idle;
+        m_TotalIdle += m_LastIdle;
+        ++m_Frames;
+        return idle;
+    }
+
+    // Idle time of the last frame and the average over all frames so far
+    inline HRClock::duration getLastIdleTime() const noexcept { return m_LastIdle; }
+    inline HRClock::duration getAverageIdleTime() const noexcept
+    {
+        return m_Frames > 0 ? m_TotalIdle / static_cast<HRClock::rep>(m_Frames) : HRClock::duration::zero();
+    }
+
+private:
+    static constexpr int calibrationSleeps{10};
+    static constexpr std::size_t workHistory{8};
+
+    // Slowest of the recent frames plus a little headroom
+    inline HRClock::duration getPredictedWork() const noexcept
+    {
+        auto predicted(*std::max_element(std::begin(m_Work), std::end(m_Work)));
+        return predicted + predicted / 8 + std::chrono::microseconds(200);
+    }
+
+    inline void waitUntil(HRClock::time_point deadline)
+    {
+        while (true)
+        {
+            const auto remaining(deadline - HRClock::now());
+            if (remaining <= HRClock::duration::zero()) return;
+
+            if (remaining > m_SleepGranularity * 2) sf::sleep(sf::milliseconds(1));
+            else std::this_thread::yield();
+        }
+    }
+
+    PacingMode m_Mode{PacingMode::VSync};
+    HRClock::duration m_Period{std::chrono::duration_cast<HRClock::duration>(std::chrono::microseconds(16667))};
+    HRClock::duration m_SleepGranularity{std::chrono::milliseconds(2)};
+    HRClock::time_point m_Deadline{HRClock::now()}, m_WorkStart{HRClock::now()};
+    HRClock::duration m_Work[workHistory]{};
+    std::size_t m_WorkHead{0};
+    HRClock::duration m_LastIdle{0}, m_TotalIdle{0};
+    std::size_t m_Frames{0};
+};
\ No newline at end of file
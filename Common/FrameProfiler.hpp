@@ -0,0 +1,212 @@
+#pragma once
+
+// Phases of a single Game::run iteration
+enum class FramePhase : std::size_t
+{
+    Events,
+    Update,         // Sum of all fixed onUpdate ticks of the frame
+    Sync,           // Waiting for the frame's jobs, or in pipelined mode for the simulation thread
+    UpdateVariable,
+    Draw,
+    Display,
+    Idle,           // Waiting for the frame pacer
+    Count
+};
+
+inline const char* getFramePhaseName(FramePhase phase) noexcept
+{
+    static const char* names[] = {"events", "update", "sync", "updateVariable", "draw", "display", "idle"};
+    return names[static_cast<std::size_t>(phase)];
+}
+
+// Rolling per-phase frame timings, collected by Game::run.
+// All durations are reported in milliseconds. While the Tracer is enabled, phases and ticks are recorded
+// as trace events too.
+class FrameProfiler
+{
+public:
+    static constexpr std::size_t historySize{256};
+    static constexpr std::size_t phaseCount{static_cast<std::size_t>(FramePhase::Count)};
+
+    // Frame time histogram: one bucket per millisecond, the last bucket collects everything above
+    static constexpr std::size_t histogramBuckets{41};
+    static constexpr float histogramBucketMs{1.f};
+
+    struct Stats
+    {
+        float min{0.f}, avg{0.f}, p95{0.f}, p99{0.f}, max{0.f};
+        std::size_t samples{0};
+    };
+
+    inline void setEnabled(bool enabled) noexcept { m_Enabled = enabled; }
+    inline bool isEnabled() const noexcept { return m_Enabled; }
+
+    // Starts a new frame and returns its start time
+    inline HRClock::time_point beginFrame() noexcept
+    {
+        if (!m_Enabled) return {};
+        m_Current = FrameRecord{};
+        return HRClock::now();
+    }
+
+    // Adds the time since `since` to `phase` and returns the current time, so phases can be chained
+    inline HRClock::time_point mark(FramePhase phase, HRClock::time_point since) noexcept
+    {
+        if (!m_Enabled) return since;
+        const auto now(HRClock::now());
+        m_Current.phases[static_cast<std::size_t>(phase)] += toMs(now - since);
+        Tracer::get().record(getFramePhaseName(phase), since, now);
+        return now;
+    }
+
+    // Records one fixed update tick (also counted towards FramePhase::Update)
+    inline HRClock::time_point markTick(HRClock::time_point since) noexcept
+    {
+        if (!m_Enabled) return since;
+        const auto now(HRClock::now());
+        addTick(now - since);
+        Tracer::get().record("tick", since, now);
+        return now;
+    }
+
+    // Records a fixed update tick that was timed elsewhere, e.g. on the simulation thread
+    inline void addTick(HRClock::duration duration) noexcept
+    {
+        if (!m_Enabled) return;
+        const auto ms(toMs(duration));
+        m_Current.phases[static_cast<std::size_t>(FramePhase::Update)] += ms;
+        ++m_Current.ticks;
+
+        m_Ticks[m_TickHead] = ms;
+        m_TickHead = (m_TickHead + 1) % historySize;
+        if (m_TickCount < historySize) ++m_TickCount;
+    }
+
+    inline void endFrame(HRClock::time_point frameStart) noexcept
+    {
+        if (!m_Enabled) return;
+        m_Current.total = toMs(HRClock::now() - frameStart);
+
+        m_Frames[m_FrameHead] = m_Current;
+        m_FrameHead = (m_FrameHead + 1) % historySize;
+        if (m_FrameCount < historySize) ++m_FrameCount;
+
+        auto bucket(static_cast<std::size_t>(m_Current.total / histogramBucketMs));
+        if (bucket >= histogramBuckets) bucket = histogramBuckets - 1;
+        ++m_Histogram[bucket];
+        ++m_TotalFrames;
+    }
+
+    inline Stats getFrameStats() const
+    {
+        return gather([](const FrameRecord& r) { return r.total; });
+    }
+
+    inline Stats getPhaseStats(FramePhase phase) const
+    {
+        const auto idx(static_cast<std::size_t>(phase));
+        return gather([idx](const FrameRecord& r) { return r.phases[idx]; });
+    }
+
+    // Statistics of individual fixed update ticks (a frame may contain zero or several)
+    inline Stats getTickStats() const
+    {
+        return computeStats(std::vector<float>(std::begin(m_Ticks), std::begin(m_Ticks) + m_TickCount));
+    }
+
+    // Frame time histogram since the last reset (not limited to the rolling window)
+    inline const std::array<std::size_t, histogramBuckets>& getHistogram() const noexcept { return m_Histogram; }
+    inline std::size_t getTotalFrames() const noexcept { return m_TotalFrames; }
+
+    inline void resetHistogram() noexcept
+    {
+        m_Histogram.fill(0);
+        m_TotalFrames = 0;
+    }
+
+    // Compact multi-line overview, meant to be put into an sf::Text
+    inline std::string getSummary() const
+    {
+        std::ostringstream ss;
+        ss << std::fixed << std::setprecision(3);
+        writeStatsLine(ss, "frame", getFrameStats());
+        for (std::size_t i(0); i < phaseCount; ++i)
+            writeStatsLine(ss, getFramePhaseName(static_cast<FramePhase>(i)), getPhaseStats(static_cast<FramePhase>(i)));
+        writeStatsLine(ss, "tick", getTickStats());
+        return ss.str();
+    }
+
+    // Full report including the histogram
+    inline void dump(std::ostream& os) const
+    {
+        os << "Frame profile (last " << m_FrameCount << " frames, ms: min/avg/p95/p99/max)\n" << getSummary();
+        os << "Frame time histogram (" << m_TotalFrames << " frames)\n";
+        for (std::size_t i(0); i < histogramBuckets; ++i)
+        {
+            if (m_Histogram[i] == 0) continue;
+            const auto from(i*histogramBucketMs);
+            if (i + 1 < histogramBuckets) os << "  " << std::setw(3) << from << "-" << std::setw(3) << from + histogramBucketMs;
+            else os << "  " << std::setw(3) << from << "+   ";
+            os << " ms: " << std::setw(8) << m_Histogram[i] << "\n";
+        }
+        os.flush();
+    }
+
+private:
+    struct FrameRecord
+    {
+        std::array<float, phaseCount> phases{};
+        float total{0.f};
+        std::size_t ticks{0};
+    };
+
+    inline static float toMs(HRClock::duration d) noexcept
+    {
+        return std::chrono::duration<float, std::milli>(d).count();
+    }
+
+    template <typename TSelector>
+    inline Stats gather(TSelector&& selector) const
+    {
+        std::vector<float> samples(m_FrameCount);
+        for (std::size_t i(0); i < m_FrameCount; ++i) samples[i] = selector(m_Frames[i]);
+        return computeStats(std::move(samples));
+    }
+
+    inline static Stats computeStats(std::vector<float> samples)
+    {
+        Stats stats;
+        stats.samples = samples.size();
+        if (samples.empty()) return stats;
+
+        std::sort(samples.begin(), samples.end());
+        const auto percentile([&samples](float p)
+        {
+            const auto idx(static_cast<std::size_t>(std::ceil(p*samples.size())));
+            return samples[idx == 0 ? 0 : idx - 1];
+        });
+
+        stats.min = samples.front();
+        stats.max = samples.back();
+        stats.avg = std::accumulate(samples.begin(), samples.end(), 0.f) / samples.size();
+        stats.p95 = percentile(0.95f);
+        stats.p99 = percentile(0.99f);
+        return stats;
+    }
+
+    inline static void writeStatsLine(std::ostream& os, const char* name, const Stats& stats)
+    {
+        os << std::setw(15) << std::left << name << std::right
+           << std::setw(8) << stats.min << std::setw(8) << stats.avg
+           << std::setw(8) << stats.p95 << std::setw(8) << stats.p99
+           << std::setw(8) << stats.max << "\n";
+    }
+
+    bool m_Enabled{true};
+    FrameRecord m_Current;
+    FrameRecord m_Frames[historySize];
+    float m_Ticks[historySize]{};
+    std::size_t m_FrameHead{0}, m_FrameCount{0}, m_TickHead{0}, m_TickCount{0};
+    std::array<std::size_t, histogramBuckets> m_Histogram{};
+    std::size_t m_TotalFrames{0};
+};
\ No newline at end of file
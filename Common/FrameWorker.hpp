@@ -0,0 +1,72 @@
+#pragma once
+
+// Dedicated thread that runs the same job once per kick().
+// Used by GameBase's pipelined mode to simulate the next frame while the current one is drawn.
+class FrameWorker
+{
+public:
+    inline explicit FrameWorker(Func<void()> job, std::string name = "frame worker")
+        : m_Job{std::move(job)},
+          m_Name{std::move(name)},
+          m_Thread{[this]() { threadMain(); }}
+    {
+    }
+
+    inline ~FrameWorker()
+    {
+        wait();
+        {
+            std::lock_guard<std::mutex> lock{m_Mutex};
+            m_Quit = true;
+        }
+        m_Cv.notify_all();
+        m_Thread.join();
+    }
+
+    FrameWorker(const FrameWorker&) = delete;
+    FrameWorker& operator=(const FrameWorker&) = delete;
+
+    // Starts one run of the job; the previous run must have been waited for
+    inline void kick()
+    {
+        {
+            std::lock_guard<std::mutex> lock{m_Mutex};
+            m_Busy = true;
+        }
+        m_Cv.notify_all();
+    }
+
+    // Blocks until the last kicked run has finished
+    inline void wait()
+    {
+        std::unique_lock<std::mutex> lock{m_Mutex};
+        m_Cv.wait(lock, [this]() { return !m_Busy; });
+    }
+
+private:
+    inline void threadMain()
+    {
+        Tracer::get().setThreadName(m_Name);
+
+        std::unique_lock<std::mutex> lock{m_Mutex};
+        while (true)
+        {
+            m_Cv.wait(lock, [this]() { return m_Busy || m_Quit; });
+            if (m_Quit) return;
+
+            lock.unlock();
+            m_Job();
+            lock.lock();
+
+            m_Busy = false;
+            m_Cv.notify_all();
+        }
+    }
+
+    Func<void()> m_Job;
+    std::string m_Name;
+    std::mutex m_Mutex;
+    std::condition_variable m_Cv;
+    bool m_Busy{false}, m_Quit{false};
+    std::thread m_Thread;
+};
\ No newline at end of file
@@ -1,34 +1,167 @@
 #pragma once
 
-class Game
+// Totals reported by Game::runHeadless
+struct RunStats
+{
+    std::size_t ticks{0}, frames{0};
+    HRClock::duration elapsed{0}, updateTime{0}, drawTime{0};
+
+    inline double getTicksPerSecond() const noexcept
+    {
+        const auto seconds(std::chrono::duration<double>(elapsed).count());
+        return seconds > 0.0 ? ticks / seconds : 0.0;
+    }
+
+    inline double getNsPerTick() const noexcept
+    {
+        return ticks > 0 ? std::chrono::duration<double, std::nano>(updateTime).count() / ticks : 0.0;
+    }
+
+    inline double getNsPerFrame() const noexcept
+    {
+        return frames > 0 ? std::chrono::duration<double, std::nano>(drawTime).count() / frames : 0.0;
+    }
+};
+
+inline std::ostream& operator<<(std::ostream& os, const RunStats& stats)
+{
+    using Ms = std::chrono::duration<double, std::milli>;
+    return os << "ticks: " << stats.ticks
+              << ", frames: " << stats.frames
+              << ", elapsed: " << Ms(stats.elapsed).count() << " ms"
+              << ", ticks/s: " << stats.getTicksPerSecond()
+              << ", update: " << stats.getNsPerTick() << " ns/tick"
+              << ", draw: " << stats.getNsPerFrame() << " ns/frame";
+}
+
+// Window, timing and the main loop shared by Game and StaticGame.
+// The loop is a template over a hooks type providing invokeLoadContent, invokeEvent, invokeUpdate,
+// invokeUpdateVariable, invokePublish, invokeDraw and invokeFpsUpdated, so the dispatch can be resolved
+// at compile time, plus hasPublish() telling whether the game publishes at all.
+//
+// The draw hook gets the interpolation alpha (time since the last fixed update / time step), so the
+// simulation can run at a lower tick rate than the display while rendering stays smooth.
+//
+// The publish hook runs on the main thread right before drawing, while no fixed update is running. It
+// should copy whatever the draw hook needs out of the simulation state: in pipelined mode the draw hook
+// runs concurrently with the next frame's fixed updates and may only read what was published. The update hook
+// must not touch anything the draw hook reads, so only games that publish can be pipelined.
+class GameBase
 {
 public:
-    Func<void(const sf::Event&)> onEvent{nullptr};
-    Func<void(float)> onUpdate{nullptr}, onUpdateVariable{nullptr};
-    Func<void()> onLoadContent{nullptr};
-    Func<void(int)> onFpsUpdated{nullptr};
-    Func<void(sf::RenderTarget&)> onDraw{nullptr};
+    // What runHeadless does with the draw hook
+    enum class HeadlessDraw
+    {
+        Skip,       // Don't draw at all, measure simulation only
+        Offscreen   // Draw every tick into an sf::RenderTexture
+    };
 
-    inline Game(const std::string& windowTitle, unsigned int windowWidth = 1024, unsigned int windowHeight = 768) noexcept
-        : m_Window{{windowWidth, windowHeight}, windowTitle},
+    inline auto getWindowWidth() const noexcept { return m_WindowWidth; }
+    inline auto getWindowHeight() const noexcept { return m_WindowHeight; }
+    inline sf::RenderWindow& getWindow() noexcept { return m_Window; }
+    inline bool isHeadless() const noexcept { return m_Headless; }
+    inline sf::Time getTimeStep() const noexcept { return m_TimeStep; }
+    inline float getTickRate() const noexcept { return 1.f / m_TimeStep.asSeconds(); }
+
+    // Rates that aren't finite and positive are ignored. The step is kept between a microsecond and an hour,
+    // so the tick accounting never divides by zero.
+    inline void setTickRate(float ticksPerSecond) noexcept
+    {
+        if (!std::isfinite(ticksPerSecond) || ticksPerSecond <= 0.f) return;
+        const auto stepUs(std::min(std::max(1e6 / ticksPerSecond, 1.0), 3600e6));
+        m_TimeStep = sf::microseconds(static_cast<sf::Int64>(stepUs));
+    }
+
+    // Upper bound of fixed updates per frame. After a stall the backlog beyond it is dropped instead of
+    // being caught up, so one slow frame can't snowball into ever longer ones.
+    inline void setMaxTicksPerFrame(std::size_t maxTicks) noexcept { m_MaxTicksPerFrame = maxTicks > 0 ? maxTicks : 1; }
+    inline std::size_t getMaxTicksPerFrame() const noexcept { return m_MaxTicksPerFrame; }
+    inline std::size_t getDroppedTicks() const noexcept { return m_DroppedTicks; }
+    inline FrameProfiler& getProfiler() noexcept { return m_Profiler; }
+    inline const FrameProfiler& getProfiler() const noexcept { return m_Profiler; }
+
+    // Frame pacing; vsync is only enabled in PacingMode::VSync (the default). Set the mode before run().
+    inline FramePacer& getPacer() noexcept { return m_Pacer; }
+    inline const FramePacer& getPacer() const noexcept { return m_Pacer; }
+
+    // Enables the Tracer; the trace is written to `path` when run() ends and whenever F9 is pressed
+    inline void setTraceFile(const std::string& path)
+    {
+        m_TraceFile = path;
+        Tracer::get().setEnabled(true);
+    }
+
+    // Scratch memory for the current frame, reset at the top of every loop iteration (main thread only)
+    inline FrameArena& getFrameArena() noexcept { return m_FrameArena; }
+
+    // Pipelined mode runs the fixed updates on a simulation thread, overlapped with drawing.
+    // Events, the variable update and publishing still run on the main thread while the simulation is idle.
+    // Only for games whose draw hook reads nothing but the published state; --pipelined is ignored by the rest.
+    inline void setPipelined(bool pipelined) noexcept { m_Pipelined = pipelined; }
+    inline bool isPipelined() const noexcept { return m_Pipelined; }
+
+    // Job system for splitting per-frame work across cores, created on first use. The pipelined loop creates it
+    // before starting the simulation thread, as both threads may be the first to use it.
+    inline JobSystem& getJobs()
+    {
+        if (m_Jobs == nullptr) m_Jobs = mkUPtr<JobSystem>(m_JobWorkerCount);
+        return *m_Jobs;
+    }
+
+    // Jobs submitted to this group are finished before the frame is published and drawn
+    inline JobGroup& getFrameJobs() noexcept { return m_FrameJobs; }
+
+    // Textures and fonts shared by the whole game, decoded on a thread of their own. The loop finalizes finished
+    // loads once per frame, before the fixed updates, so ready callbacks run on the main thread.
+    inline ResourceCache& getResources()
+    {
+        if (m_Resources == nullptr) m_Resources = mkUPtr<ResourceCache>();
+        return *m_Resources;
+    }
+
+    // Only has an effect before the first call to getJobs()
+    inline void setJobWorkerCount(std::size_t workerCount) noexcept { m_JobWorkerCount = workerCount; }
+
+protected:
+    // The window is only opened by run(), so a game can be constructed on machines without a display.
+    inline GameBase(const std::string& windowTitle, unsigned int windowWidth, unsigned int windowHeight) noexcept
+        : m_WindowTitle{windowTitle},
           m_WindowWidth{windowWidth},
           m_WindowHeight{windowHeight}
     {
-        m_Window.setVerticalSyncEnabled(true);
     }
 
-    inline void run()
+    template <typename THooks>
+    inline void runLoop(THooks& hooks)
     {
-        safeInvoke(onLoadContent);
-        safeInvoke(onFpsUpdated, 0);
+        Tracer::get().setThreadName("main");
+        m_Window.create({m_WindowWidth, m_WindowHeight}, m_WindowTitle);
+        m_Window.setVerticalSyncEnabled(m_Pacer.getMode() == PacingMode::VSync);
+        if (m_Pacer.getMode() != PacingMode::VSync) m_Pacer.calibrate();
+
+        hooks.invokeLoadContent();
+        hooks.invokeFpsUpdated(0);
 
-        static const auto timeStep(sf::seconds(1.f/60.f));
+        if (m_Pipelined) runPipelinedLoop(hooks);
+        else runSerialLoop(hooks);
 
+        dumpTrace();
+    }
+
+    template <typename THooks>
+    inline void runSerialLoop(THooks& hooks)
+    {
         auto timeSinceLastUpdate(sf::Time::Zero);
         sf::Clock clock;
 
         while (m_Window.isOpen())
         {
+            TRACE_SCOPE("frame");
+            m_FrameArena.reset();
+            const auto frameStart(m_Profiler.beginFrame());
+            m_Pacer.beginFrame();
+            auto mark(m_Profiler.mark(FramePhase::Idle, frameStart));
+
             auto dt(clock.restart());
             timeSinceLastUpdate += dt;
 
@@ -40,30 +173,323 @@ public:
                     m_Window.close();
                     break;
                 }
-                safeInvoke(onEvent, event);
+                if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F9) dumpTrace();
+                hooks.invokeEvent(event);
             }
+            finalizeResources();
+            mark = m_Profiler.mark(FramePhase::Events, mark);
 
-            while (timeSinceLastUpdate >= timeStep)
+            for (auto ticks(consumeTicks(timeSinceLastUpdate)); ticks > 0; --ticks)
             {
-                timeSinceLastUpdate -= timeStep;
-                safeInvoke(onUpdate, timeStep.asSeconds());
+                hooks.invokeUpdate(m_TimeStep.asSeconds());
+                mark = m_Profiler.markTick(mark);
             }
 
-            updateFpsCounter(dt);
-            safeInvoke(onUpdateVariable, dt.asSeconds());
+            updateFpsCounter(hooks, dt);
+            hooks.invokeUpdateVariable(dt.asSeconds());
+            mark = m_Profiler.mark(FramePhase::UpdateVariable, mark);
+
+            waitFrameJobs();
+            mark = m_Profiler.mark(FramePhase::Sync, mark);
 
             m_Window.clear(sf::Color::White);
-            safeInvoke(onDraw, m_Window);
+            hooks.invokePublish();
+            hooks.invokeDraw(m_Window, getAlpha(timeSinceLastUpdate));
+            mark = m_Profiler.mark(FramePhase::Draw, mark);
+
             m_Window.display();
+            mark = m_Profiler.mark(FramePhase::Display, mark);
+
+            m_Pacer.endFrame();
+            m_Profiler.mark(FramePhase::Idle, mark);
+            m_Profiler.endFrame(frameStart);
         }
     }
 
-    inline auto getWindowWidth() const noexcept { return m_WindowWidth; }
-    inline auto getWindowHeight() const noexcept { return m_WindowHeight; }
-    inline sf::RenderWindow& getWindow() noexcept { return m_Window; }
+    // Frame N's fixed updates run on the simulation thread while frame N-1's published state is drawn.
+    // Each iteration first waits for the simulation to go idle; only then are queued events, the variable
+    // update and publish dispatched, after which the simulation is kicked off again and drawing starts.
+    template <typename THooks>
+    inline void runPipelinedLoop(THooks& hooks)
+    {
+        const auto ft(m_TimeStep.asSeconds());
+        std::size_t pendingTicks{0};
+        std::vector<HRClock::duration> tickTimes;
+
+        // Creating it lazily from both threads would race
+        getJobs();
+
+        FrameWorker simulation{[this, &hooks, &pendingTicks, &tickTimes, ft]()
+        {
+            for (; pendingTicks > 0; --pendingTicks)
+            {
+                TRACE_SCOPE("tick");
+                const auto tickStart(HRClock::now());
+                hooks.invokeUpdate(ft);
+                tickTimes.emplace_back(HRClock::now() - tickStart);
+            }
+            waitFrameJobs();
+        }, "simulation"};
+
+        auto timeSinceLastUpdate(sf::Time::Zero);
+        std::vector<sf::Event> events;
+        sf::Clock clock;
+
+        while (m_Window.isOpen())
+        {
+            TRACE_SCOPE("frame");
+            m_FrameArena.reset();
+            const auto frameStart(m_Profiler.beginFrame());
+            m_Pacer.beginFrame();
+            auto mark(m_Profiler.mark(FramePhase::Idle, frameStart));
+
+            auto dt(clock.restart());
+            timeSinceLastUpdate += dt;
+
+            events.clear();
+            sf::Event event;
+            while (m_Window.pollEvent(event))
+            {
+                if (event.type == sf::Event::Closed)
+                {
+                    m_Window.close();
+                    break;
+                }
+                if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F9) dumpTrace();
+                events.emplace_back(event);
+            }
+            mark = m_Profiler.mark(FramePhase::Events, mark);
+
+            simulation.wait();
+            mark = m_Profiler.mark(FramePhase::Sync, mark);
+            for (const auto& t : tickTimes) m_Profiler.addTick(t);
+            tickTimes.clear();
+
+            // The simulation is idle from here until kick()
+            for (const auto& e : events) hooks.invokeEvent(e);
+            finalizeResources();
+            mark = m_Profiler.mark(FramePhase::Events, mark);
+
+            updateFpsCounter(hooks, dt);
+            hooks.invokeUpdateVariable(dt.asSeconds());
+            mark = m_Profiler.mark(FramePhase::UpdateVariable, mark);
+
+            waitFrameJobs();
+            mark = m_Profiler.mark(FramePhase::Sync, mark);
+
+            hooks.invokePublish();
+
+            pendingTicks = consumeTicks(timeSinceLastUpdate);
+            simulation.kick();
+
+            m_Window.clear(sf::Color::White);
+            hooks.invokeDraw(m_Window, getAlpha(timeSinceLastUpdate));
+            mark = m_Profiler.mark(FramePhase::Draw, mark);
+
+            m_Window.display();
+            mark = m_Profiler.mark(FramePhase::Display, mark);
+
+            m_Pacer.endFrame();
+            m_Profiler.mark(FramePhase::Idle, mark);
+            m_Profiler.endFrame(frameStart);
+        }
+
+        simulation.wait();
+    }
+
+    // Runs tickCount fixed steps back to back without a window (and without vsync), then reports totals.
+    // Every tick is followed by the variable update with the same fixed step, so variable-rate demos advance too.
+    template <typename THooks>
+    inline RunStats runHeadlessLoop(THooks& hooks, std::size_t tickCount, HeadlessDraw drawMode)
+    {
+        m_Headless = true;
+        Tracer::get().setThreadName("main");
+
+        // Offscreen drawing needs a GL context; fall back to skipping the draw if none is available
+        if (drawMode == HeadlessDraw::Offscreen && !m_Offscreen.create(m_WindowWidth, m_WindowHeight))
+            drawMode = HeadlessDraw::Skip;
+
+        hooks.invokeLoadContent();
+        hooks.invokeFpsUpdated(0);
+
+        const auto ft(m_TimeStep.asSeconds());
+        const auto drawOffscreen(drawMode == HeadlessDraw::Offscreen);
+
+        RunStats stats;
+        const auto start(HRClock::now());
+        for (std::size_t i(0); i < tickCount; ++i)
+        {
+            // Every tick counts as one profiler frame
+            TRACE_SCOPE("frame");
+            m_FrameArena.reset();
+            const auto frameStart(m_Profiler.beginFrame());
+
+            // Per-tick timestamps are only needed to tell the update apart from the draw
+            const auto updateStart(drawOffscreen ? HRClock::now() : frameStart);
+            finalizeResources();
+            hooks.invokeUpdate(ft);
+            auto mark(m_Profiler.markTick(updateStart));
+            hooks.invokeUpdateVariable(ft);
+            mark = m_Profiler.mark(FramePhase::UpdateVariable, mark);
+            waitFrameJobs();
+            mark = m_Profiler.mark(FramePhase::Sync, mark);
+            ++stats.ticks;
+
+            if (drawOffscreen)
+            {
+                const auto updateEnd(HRClock::now());
+                stats.updateTime += updateEnd - updateStart;
+
+                m_Offscreen.clear(sf::Color::White);
+                hooks.invokePublish();
+                hooks.invokeDraw(m_Offscreen, 1.f);
+                mark = m_Profiler.mark(FramePhase::Draw, mark);
+                m_Offscreen.display();
+                m_Profiler.mark(FramePhase::Display, mark);
+                stats.drawTime += HRClock::now() - updateEnd;
+                ++stats.frames;
+            }
+
+            m_Profiler.endFrame(frameStart);
+        }
+        stats.elapsed = HRClock::now() - start;
+        if (!drawOffscreen) stats.updateTime = stats.elapsed;
+
+        m_Headless = false;
+        dumpTrace();
+        return stats;
+    }
+
+    // Entry point for demo mains. Understands:
+    //   --headless [ticks]   run headless for the given number of ticks (default 600) and print totals
+    //   --offscreen          with --headless, also draw every tick into an offscreen target
+    //   --profile            dump the frame profile to stdout when the run ends
+    //   --pipelined          run the fixed updates on a simulation thread (see setPipelined); needs a publish hook
+    //   --threads N          number of job system worker threads (see setJobWorkerCount)
+    //   --tick-rate HZ       fixed updates per second (see setTickRate)
+    //   --max-ticks N        fixed updates per frame before the backlog is dropped (see setMaxTicksPerFrame)
+    //   --pacing MODE        vsync (default), uncapped, target or lowlatency (see FramePacer)
+    //   --fps N              target frame rate of the target and lowlatency pacing modes
+    //   --trace FILE         record a Chrome trace and write it to FILE (see setTraceFile)
+    template <typename THooks>
+    inline int runFromArgs(THooks& hooks, int argc, char* argv[])
+    {
+        auto headless(false), profile(false);
+        auto drawMode(HeadlessDraw::Skip);
+        std::size_t tickCount{600};
+
+        for (auto i(1); i < argc; ++i)
+        {
+            if (std::strcmp(argv[i], "--headless") == 0)
+            {
+                headless = true;
+                if (i + 1 < argc && std::isdigit(static_cast<unsigned char>(argv[i + 1][0])))
+                    tickCount = std::strtoul(argv[++i], nullptr, 10);
+            }
+            else if (std::strcmp(argv[i], "--offscreen") == 0)
+            {
+                drawMode = HeadlessDraw::Offscreen;
+            }
+            else if (std::strcmp(argv[i], "--profile") == 0)
+            {
+                profile = true;
+            }
+            else if (std::strcmp(argv[i], "--pipelined") == 0)
+            {
+                if (hooks.hasPublish()) m_Pipelined = true;
+                else std::cerr << m_WindowTitle << ": --pipelined needs a publish hook, running serially" << std::endl;
+            }
+            else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            {
+                m_JobWorkerCount = std::strtoul(argv[++i], nullptr, 10);
+            }
+            else if (std::strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc)
+            {
+                setTickRate(std::strtof(argv[++i], nullptr));
+            }
+            else if (std::strcmp(argv[i], "--max-ticks") == 0 && i + 1 < argc)
+            {
+                setMaxTicksPerFrame(std::strtoul(argv[++i], nullptr, 10));
+            }
+            else if (std::strcmp(argv[i], "--pacing") == 0 && i + 1 < argc)
+            {
+                const auto mode(argv[++i]);
+                if (std::strcmp(mode, "uncapped") == 0) m_Pacer.setMode(PacingMode::Uncapped);
+                else if (std::strcmp(mode, "target") == 0) m_Pacer.setMode(PacingMode::TargetRate);
+                else if (std::strcmp(mode, "lowlatency") == 0) m_Pacer.setMode(PacingMode::LowLatency);
+                else m_Pacer.setMode(PacingMode::VSync);
+            }
+            else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+            {
+                setTraceFile(argv[++i]);
+            }
+            else if (std::strcmp(argv[i], "--fps") == 0 && i + 1 < argc)
+            {
+                const auto fps(std::strtof(argv[++i], nullptr));
+                if (fps > 0.f) m_Pacer.setTargetFrameRate(fps);
+            }
+        }
+
+        if (headless)
+        {
+            const auto stats(runHeadlessLoop(hooks, tickCount, drawMode));
+            std::cout << m_WindowTitle << " (headless) - " << stats << std::endl;
+        }
+        else runLoop(hooks);
+
+        if (profile)
+        {
+            m_Profiler.dump(std::cout);
+            std::cout << "Frame arena high-water mark: " << m_FrameArena.getHighWaterMark() << " bytes, "
+                      << m_FrameArena.getOverflowCount() << " heap fallbacks" << std::endl;
+            if (!headless)
+                std::cout << "Average idle time per frame: "
+                          << std::chrono::duration<double, std::milli>(m_Pacer.getAverageIdleTime()).count() << " ms" << std::endl;
+        }
+        return 0;
+    }
 
 private:
-    inline void updateFpsCounter(sf::Time deltaTime) noexcept
+    // Takes as many whole time steps out of the accumulator as this frame may run
+    inline std::size_t consumeTicks(sf::Time& timeSinceLastUpdate) noexcept
+    {
+        const auto step(m_TimeStep.asMicroseconds());
+        auto ticks(static_cast<std::size_t>(timeSinceLastUpdate.asMicroseconds() / step));
+        if (ticks > m_MaxTicksPerFrame)
+        {
+            m_DroppedTicks += ticks - m_MaxTicksPerFrame;
+            ticks = m_MaxTicksPerFrame;
+        }
+
+        // Whatever is dropped, keep the fraction of the current step so the alpha stays continuous
+        timeSinceLastUpdate = sf::microseconds(timeSinceLastUpdate.asMicroseconds() % step);
+        return ticks;
+    }
+
+    inline float getAlpha(sf::Time timeSinceLastUpdate) const noexcept
+    {
+        return timeSinceLastUpdate / m_TimeStep;
+    }
+
+    inline void waitFrameJobs()
+    {
+        if (m_Jobs != nullptr) m_Jobs->wait(m_FrameJobs);
+    }
+
+    inline void finalizeResources()
+    {
+        if (m_Resources != nullptr) m_Resources->finalize();
+    }
+
+    inline void dumpTrace() const
+    {
+        if (m_TraceFile.empty()) return;
+        if (Tracer::get().dump(m_TraceFile)) std::cout << "Trace written to " << m_TraceFile << std::endl;
+        else std::cerr << "Could not write trace to " << m_TraceFile << std::endl;
+    }
+
+    template <typename THooks>
+    inline void updateFpsCounter(THooks& hooks, sf::Time deltaTime)
     {
         static const auto oneSecond(sf::seconds(1.f));
         m_FpsCounterTime += deltaTime;
@@ -73,19 +499,83 @@ private:
             m_LastFps = m_FpsCounter;
             m_FpsCounterTime -= oneSecond;
             m_FpsCounter = 0;
-            safeInvoke(onFpsUpdated, m_LastFps);
+            hooks.invokeFpsUpdated(static_cast<int>(m_LastFps));
         }
     }
 
+    sf::RenderWindow m_Window;
+    sf::RenderTexture m_Offscreen;
+    std::string m_WindowTitle, m_TraceFile;
+    unsigned int m_WindowWidth, m_WindowHeight;
+    sf::Time m_TimeStep{sf::seconds(1.f/60.f)};
+    std::size_t m_MaxTicksPerFrame{5}, m_DroppedTicks{0};
+    sf::Time m_FpsCounterTime{sf::Time::Zero};
+    std::size_t m_FpsCounter{0}, m_LastFps{0};
+    FrameProfiler m_Profiler;
+    FramePacer m_Pacer;
+    FrameArena m_FrameArena;
+    bool m_Headless{false}, m_Pipelined{false};
+    std::size_t m_JobWorkerCount{JobSystem::getDefaultWorkerCount()};
+    JobGroup m_FrameJobs;
+    UPtr<JobSystem> m_Jobs;
+    UPtr<ResourceCache> m_Resources;
+};
+
+// Game whose hooks are assigned at runtime through std::functions.
+// See StaticGame for a variant where the hooks are resolved at compile time.
+class Game : public GameBase
+{
+public:
+    Func<void(const sf::Event&)> onEvent{nullptr};
+    Func<void(float)> onUpdate{nullptr}, onUpdateVariable{nullptr};
+    Func<void()> onLoadContent{nullptr};
+    Func<void(int)> onFpsUpdated{nullptr};
+    Func<void()> onPublish{nullptr};
+    Func<void(sf::RenderTarget&, float)> onDraw{nullptr};
+
+    inline Game(const std::string& windowTitle, unsigned int windowWidth = 1024, unsigned int windowHeight = 768) noexcept
+        : GameBase{windowTitle, windowWidth, windowHeight}
+    {
+    }
+
+    inline void run()
+    {
+        FuncHooks hooks{*this};
+        runLoop(hooks);
+    }
+
+    inline RunStats runHeadless(std::size_t tickCount, HeadlessDraw drawMode = HeadlessDraw::Skip)
+    {
+        FuncHooks hooks{*this};
+        return runHeadlessLoop(hooks, tickCount, drawMode);
+    }
+
+    inline int run(int argc, char* argv[])
+    {
+        FuncHooks hooks{*this};
+        return runFromArgs(hooks, argc, argv);
+    }
+
+private:
+    // Forwards the loop's hook calls to the std::function members
+    struct FuncHooks
+    {
+        Game& game;
+
+        inline void invokeLoadContent() { safeInvoke(game.onLoadContent); }
+        inline void invokeEvent(const sf::Event& event) { safeInvoke(game.onEvent, event); }
+        inline void invokeUpdate(float ft) { safeInvoke(game.onUpdate, ft); }
+        inline void invokeUpdateVariable(float dt) { safeInvoke(game.onUpdateVariable, dt); }
+        inline void invokePublish() { safeInvoke(game.onPublish); }
+        inline bool hasPublish() const noexcept { return game.onPublish != nullptr; }
+        inline void invokeDraw(sf::RenderTarget& target, float alpha) { safeInvoke(game.onDraw, target, alpha); }
+        inline void invokeFpsUpdated(int fps) { safeInvoke(game.onFpsUpdated, fps); }
+    };
+
     // Safely invoke an std::function (check whether it is null)
     template <typename TFunc, typename... TArgs>
     inline static void safeInvoke(TFunc& func, TArgs&&... args)
     {
         if (func != nullptr) func(FWD(args)...);
     }
-
-    sf::RenderWindow m_Window;
-    unsigned int m_WindowWidth, m_WindowHeight;
-    sf::Time m_FpsCounterTime{sf::Time::Zero};
-    std::size_t m_FpsCounter{0}, m_LastFps{0};
 };
\ No newline at end of file
@@ -0,0 +1,283 @@
+#pragma once
+
+// Tracks a set of submitted jobs; JobSystem::wait blocks until all of them have run
+class JobGroup
+{
+public:
+    inline bool isDone() const noexcept { return m_Pending.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class JobSystem;
+    std::atomic<std::size_t> m_Pending{0};
+};
+
+// Jobs with dependencies, run by JobSystem::run. A task starts once every task that precedes it has finished.
+class TaskGraph
+{
+public:
+    using TaskId = std::size_t;
+
+    inline TaskId add(Func<void()> fn)
+    {
+        m_Nodes.emplace_back();
+        m_Nodes.back().fn = std::move(fn);
+        return m_Nodes.size() - 1;
+    }
+
+    // `after` won't start before `before` has finished
+    inline void precede(TaskId before, TaskId after)
+    {
+        assert(before < m_Nodes.size() && after < m_Nodes.size());
+        m_Nodes[before].successors.emplace_back(after);
+        ++m_Nodes[after].dependencyCount;
+    }
+
+    inline std::size_t getTaskCount() const noexcept { return m_Nodes.size(); }
+
+    inline void clear()
+    {
+        m_Nodes.clear();
+        m_Remaining.reset();
+    }
+
+private:
+    friend class JobSystem;
+
+    struct Node
+    {
+        Func<void()> fn;
+        std::vector<TaskId> successors;
+        std::size_t dependencyCount{0};
+    };
+
+    std::vector<Node> m_Nodes;
+    UPtr<std::atomic<std::size_t>[]> m_Remaining;
+};
+
+// Work-stealing job scheduler. Every worker owns a queue: it pushes and pops at the back and steals from
+// the front of the other queues when its own runs dry. Threads that aren't workers (e.g. the main thread)
+// share one extra queue. Waiting threads don't block, they help running jobs until their group is done.
+class JobSystem
+{
+public:
+    inline static std::size_t getDefaultWorkerCount() noexcept
+    {
+        const auto hardwareThreads(std::thread::hardware_concurrency());
+        return hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+    }
+
+    // With zero workers every job runs on the thread that waits for it
+    inline explicit JobSystem(std::size_t workerCount = getDefaultWorkerCount())
+        : m_Queues(workerCount + 1)
+    {
+        for (auto& q : m_Queues) q = mkUPtr<WorkQueue>();
+
+        m_Workers.reserve(workerCount);
+        for (std::size_t i(0); i < workerCount; ++i)
+            m_Workers.emplace_back([this, i]() { workerMain(i + 1); });
+    }
+
+    inline ~JobSystem()
+    {
+        {
+            std::lock_guard<std::mutex> lock{m_SleepMutex};
+            m_Quit = true;
+        }
+        m_SleepCv.notify_all();
+        for (auto& w : m_Workers) w.join();
+    }
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // Workers plus the calling thread
+    inline std::size_t getThreadCount() const noexcept { return m_Workers.size() + 1; }
+
+    inline void submit(JobGroup& group, Func<void()> job)
+    {
+        group.m_Pending.fetch_add(1, std::memory_order_relaxed);
+        push(Task{std::move(job), &group, nullptr, 0});
+    }
+
+    // Runs queued jobs on the calling thread until every job of `group` has finished
+    inline void wait(JobGroup& group)
+    {
+        while (!group.isDone())
+        {
+            if (!tryRunOne()) std::this_thread::yield();
+        }
+    }
+
+    // Calls fn(first, last) for consecutive ranges of at most grainSize elements covering [begin, end)
+    // and returns once all of them have run. The calling thread takes the first range itself.
+    template <typename TFunc>
+    inline void parallelFor(std::size_t begin, std::size_t end, std::size_t grainSize, TFunc&& fn)
+    {
+        if (begin >= end) return;
+        if (grainSize == 0) grainSize = 1;
+
+        JobGroup group;
+        for (auto first(begin + grainSize); first < end; first += grainSize)
+        {
+            const auto last(std::min(first + grainSize, end));
+            submit(group, [&fn, first, last]() { fn(first, last); });
+        }
+
+        fn(begin, std::min(begin + grainSize, end));
+        wait(group);
+    }
+
+    // Schedules every task of `graph` under `group`; `graph` has to stay alive until the group is done
+    inline void run(TaskGraph& graph, JobGroup& group)
+    {
+        const auto count(graph.m_Nodes.size());
+        if (count == 0) return;
+
+        graph.m_Remaining.reset(new std::atomic<std::size_t>[count]);
+        for (std::size_t i(0); i < count; ++i) graph.m_Remaining[i].store(graph.m_Nodes[i].dependencyCount, std::memory_order_relaxed);
+
+        group.m_Pending.fetch_add(count, std::memory_order_relaxed);
+        for (std::size_t i(0); i < count; ++i)
+            if (graph.m_Nodes[i].dependencyCount == 0) push(Task{nullptr, &group, &graph, i});
+    }
+
+    // Runs `graph` to completion, helping on the calling thread
+    inline void run(TaskGraph& graph)
+    {
+        JobGroup group;
+        run(graph, group);
+        wait(group);
+    }
+
+private:
+    // Either a plain job or node `node` of `graph`
+    struct Task
+    {
+        Func<void()> fn;
+        JobGroup* group;
+        TaskGraph* graph;
+        std::size_t node;
+    };
+
+    struct WorkQueue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    // Queue index of the calling thread for this job system (0 for non-worker threads)
+    inline std::size_t& getLocalIndex() noexcept
+    {
+        static thread_local const JobSystem* owner{nullptr};
+        static thread_local std::size_t index{0};
+        if (owner != this)
+        {
+            owner = this;
+            index = 0;
+        }
+        return index;
+    }
+
+    inline void push(Task task)
+    {
+        auto& queue(*m_Queues[getLocalIndex()]);
+        {
+            std::lock_guard<std::mutex> lock{queue.mutex};
+            queue.tasks.emplace_back(std::move(task));
+        }
+
+        {
+            std::lock_guard<std::mutex> lock{m_SleepMutex};
+            ++m_Queued;
+        }
+        m_SleepCv.notify_one();
+    }
+
+    inline bool tryPop(Task& out)
+    {
+        const auto self(getLocalIndex());
+
+        // Own queue first, newest task (still warm in cache)
+        {
+            auto& queue(*m_Queues[self]);
+            std::lock_guard<std::mutex> lock{queue.mutex};
+            if (!queue.tasks.empty())
+            {
+                out = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+                return true;
+            }
+        }
+
+        // Then steal the oldest task of another queue
+        const auto queueCount(m_Queues.size());
+        for (std::size_t i(1); i < queueCount; ++i)
+        {
+            auto& queue(*m_Queues[(self + i) % queueCount]);
+            std::lock_guard<std::mutex> lock{queue.mutex};
+            if (!queue.tasks.empty())
+            {
+                out = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    inline bool tryRunOne()
+    {
+        Task task;
+        if (!tryPop(task)) return false;
+
+        {
+            std::lock_guard<std::mutex> lock{m_SleepMutex};
+            --m_Queued;
+        }
+
+        execute(task);
+        return true;
+    }
+
+    inline void execute(Task& task)
+    {
+        if (task.graph == nullptr)
+        {
+            task.fn();
+        }
+        else
+        {
+            auto& graph(*task.graph);
+            graph.m_Nodes[task.node].fn();
+            for (auto successor : graph.m_Nodes[task.node].successors)
+                if (graph.m_Remaining[successor].fetch_sub(1, std::memory_order_acq_rel) == 1)
+                    push(Task{nullptr, task.group, task.graph, successor});
+        }
+
+        task.group->m_Pending.fetch_sub(1, std::memory_order_release);
+    }
+
+    inline void workerMain(std::size_t index)
+    {
+        getLocalIndex() = index;
+        Tracer::get().setThreadName("job worker " + std::to_string(index));
+
+        while (true)
+        {
+            if (tryRunOne()) continue;
+
+            std::unique_lock<std::mutex> lock{m_SleepMutex};
+            m_SleepCv.wait(lock, [this]() { return m_Quit || m_Queued > 0; });
+            if (m_Quit) return;
+        }
+    }
+
+    std::vector<UPtr<WorkQueue>> m_Queues;
+    std::vector<std::thread> m_Workers;
+
+    std::mutex m_SleepMutex;
+    std::condition_variable m_SleepCv;
+    std::size_t m_Queued{0};
+    bool m_Quit{false};
+};
\ No newline at end of file
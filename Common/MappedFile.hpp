@@ -0,0 +1,150 @@
+#pragma once
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#define MAPPED_FILE_POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Read-only view of a whole file, memory-mapped where the platform supports it (POSIX and Windows) and read
+// into memory otherwise. Pages are only loaded when touched, so opening is cheap regardless of the file size.
+// Not part of Common.hpp, since it pulls in the platform headers.
+class MappedFile
+{
+public:
+    inline MappedFile() = default;
+    inline ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    inline MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+    inline MappedFile& operator=(MappedFile&& other) noexcept
+    {
+        if (this == &other) return *this;
+        close();
+        m_Data = other.m_Data;
+        m_Size = other.m_Size;
+        m_Fallback = std::move(other.m_Fallback);
+#if defined(_WIN32)
+        m_File = other.m_File;
+        m_Mapping = other.m_Mapping;
+        other.m_File = INVALID_HANDLE_VALUE;
+        other.m_Mapping = nullptr;
+#endif
+        other.m_Data = nullptr;
+        other.m_Size = 0;
+        return *this;
+    }
+
+    inline bool open(const std::string& path)
+    {
+        close();
+
+#if defined(MAPPED_FILE_POSIX)
+        const auto fd(::open(path.c_str(), O_RDONLY));
+        if (fd < 0) return false;
+
+        struct stat info;
+        if (::fstat(fd, &info) != 0)
+        {
+            ::close(fd);
+            return false;
+        }
+
+        m_Size = static_cast<std::size_t>(info.st_size);
+        if (m_Size > 0)
+        {
+            // The mapping stays valid after closing the descriptor
+            const auto data(::mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, fd, 0));
+            if (data == MAP_FAILED)
+            {
+                ::close(fd);
+                m_Size = 0;
+                return false;
+            }
+            m_Data = static_cast<const unsigned char*>(data);
+        }
+        ::close(fd);
+        return true;
+#elif defined(_WIN32)
+        m_File = ::CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (m_File == INVALID_HANDLE_VALUE) return false;
+
+        LARGE_INTEGER size;
+        if (!::GetFileSizeEx(m_File, &size))
+        {
+            close();
+            return false;
+        }
+
+        m_Size = static_cast<std::size_t>(size.QuadPart);
+        if (m_Size > 0)
+        {
+            m_Mapping = ::CreateFileMappingA(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            const auto data(m_Mapping != nullptr ? ::MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0) : nullptr);
+            if (data == nullptr)
+            {
+                close();
+                return false;
+            }
+            m_Data = static_cast<const unsigned char*>(data);
+        }
+        return true;
+#else
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file) return false;
+
+        m_Fallback.resize(static_cast<std::size_t>(file.tellg()));
+        file.seekg(0);
+        if (!file.read(reinterpret_cast<char*>(m_Fallback.data()), static_cast<std::streamsize>(m_Fallback.size()))) return false;
+        m_Data = m_Fallback.data();
+        m_Size = m_Fallback.size();
+        return true;
+#endif
+    }
+
+    inline void close() noexcept
+    {
+#if defined(MAPPED_FILE_POSIX)
+        if (m_Data != nullptr) ::munmap(const_cast<unsigned char*>(m_Data), m_Size);
+#elif defined(_WIN32)
+        if (m_Data != nullptr) ::UnmapViewOfFile(m_Data);
+        if (m_Mapping != nullptr) ::CloseHandle(m_Mapping);
+        if (m_File != INVALID_HANDLE_VALUE) ::CloseHandle(m_File);
+        m_Mapping = nullptr;
+        m_File = INVALID_HANDLE_VALUE;
+#endif
+        m_Fallback.clear();
+        m_Data = nullptr;
+        m_Size = 0;
+    }
+
+    inline bool isOpen() const noexcept { return m_Data != nullptr; }
+    inline const unsigned char* getData() const noexcept { return m_Data; }
+    inline std::size_t getSize() const noexcept { return m_Size; }
+
+private:
+    const unsigned char* m_Data{nullptr};
+    std::size_t m_Size{0};
+    std::vector<unsigned char> m_Fallback;
+#if defined(_WIN32)
+    HANDLE m_File{INVALID_HANDLE_VALUE};
+    HANDLE m_Mapping{nullptr};
+#endif
+};
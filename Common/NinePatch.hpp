@@ -65,6 +65,7 @@ private:
 
     inline void updateVerticesPos()
     {
+        TRACE_SCOPE("NinePatch::updateVerticesPos");
         const auto px(m_PatchSize.x), py(m_PatchSize.y);
         const auto sx(m_Size.x), sy(m_Size.y);
 
@@ -0,0 +1,363 @@
+#pragma once
+#include <unordered_map>
+
+// How a resource type is loaded. decode() runs on the resource decoder thread and does the file I/O and decoding;
+// finalize() runs on the main thread afterwards for whatever needs the GL context.
+template <typename T>
+struct ResourceLoader;
+
+template <>
+struct ResourceLoader<sf::Texture>
+{
+    using Staging = sf::Image;
+
+    inline static bool decode(const std::string& path, Staging& image, sf::Texture&) { return image.loadFromFile(path); }
+
+    inline static bool finalize(Staging& image, sf::Texture& texture)
+    {
+        const auto uploaded(texture.loadFromImage(image));
+        image = sf::Image{};
+        return uploaded;
+    }
+
+    inline static std::size_t getSize(const sf::Texture& texture, const Staging&)
+    {
+        return static_cast<std::size_t>(texture.getSize().x) * texture.getSize().y * 4;
+    }
+};
+
+template <>
+struct ResourceLoader<sf::Font>
+{
+    // The font reads its glyphs from the file contents for as long as it lives
+    using Staging = std::vector<char>;
+
+    inline static bool decode(const std::string& path, Staging& data, sf::Font& font)
+    {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file) return false;
+
+        data.resize(static_cast<std::size_t>(file.tellg()));
+        file.seekg(0);
+        return file.read(data.data(), static_cast<std::streamsize>(data.size())) && font.loadFromMemory(data.data(), data.size());
+    }
+
+    inline static bool finalize(Staging&, sf::Font&) { return true; }
+    inline static std::size_t getSize(const sf::Font&, const Staging& data) { return data.size(); }
+};
+
+enum class ResourceState
+{
+    Loading,
+    Ready,
+    Failed
+};
+
+// Thread that runs the decodes, one after the other in submission order. It's not part of the job system, so
+// the waits of frame-critical work never pick up a decode and stall on file I/O.
+class ResourceDecoder
+{
+public:
+    inline ResourceDecoder() : m_Thread{[this]() { threadMain(); }} { }
+
+    // Decodes that haven't started are dropped
+    inline ~ResourceDecoder()
+    {
+        {
+            std::lock_guard<std::mutex> lock{m_Mutex};
+            m_Quit = true;
+        }
+        m_Cv.notify_all();
+        m_Thread.join();
+    }
+
+    ResourceDecoder(const ResourceDecoder&) = delete;
+    ResourceDecoder& operator=(const ResourceDecoder&) = delete;
+
+    inline void submit(Func<void()> decode)
+    {
+        {
+            std::lock_guard<std::mutex> lock{m_Mutex};
+            m_Queue.emplace_back(std::move(decode));
+        }
+        m_Cv.notify_all();
+    }
+
+    // Blocks until every submitted decode has run
+    inline void wait()
+    {
+        std::unique_lock<std::mutex> lock{m_Mutex};
+        m_Cv.wait(lock, [this]() { return m_Queue.empty() && !m_Busy; });
+    }
+
+private:
+    inline void threadMain()
+    {
+        Tracer::get().setThreadName("resource decoder");
+
+        std::unique_lock<std::mutex> lock{m_Mutex};
+        while (true)
+        {
+            m_Cv.wait(lock, [this]() { return !m_Queue.empty() || m_Quit; });
+            if (m_Quit) return;
+
+            auto decode(std::move(m_Queue.front()));
+            m_Queue.pop_front();
+            m_Busy = true;
+            lock.unlock();
+
+            decode();
+
+            lock.lock();
+            m_Busy = false;
+            if (m_Queue.empty()) m_Cv.notify_all();
+        }
+    }
+
+    std::mutex m_Mutex;
+    std::condition_variable m_Cv;
+    std::deque<Func<void()>> m_Queue;
+    bool m_Busy{false}, m_Quit{false};
+    std::thread m_Thread;
+};
+
+template <typename T>
+class ResourcePool;
+
+// Shared reference to a cached resource. The resource may only be used once it's ready, which happens during
+// a later ResourceCache::finalize() on the main thread; as long as a handle exists it won't be evicted.
+template <typename T>
+class ResourceHandle
+{
+public:
+    inline ResourceHandle() = default;
+
+    inline bool isValid() const noexcept { return m_Entry != nullptr; }
+    inline ResourceState getState() const noexcept { return m_Entry != nullptr ? m_Entry->state : ResourceState::Failed; }
+    inline bool isReady() const noexcept { return getState() == ResourceState::Ready; }
+    inline bool hasFailed() const noexcept { return getState() == ResourceState::Failed; }
+
+    inline const T& get() const noexcept
+    {
+        assert(isReady());
+        return m_Entry->resource;
+    }
+
+    inline const std::string& getPath() const noexcept { return m_Entry->path; }
+
+private:
+    friend class ResourcePool<T>;
+
+    struct Entry
+    {
+        std::string path;
+        T resource;
+        typename ResourceLoader<T>::Staging staging;
+        std::atomic<bool> decoded{false};
+        bool decodeSucceeded{false};
+
+        // Main thread only
+        ResourceState state{ResourceState::Loading};
+        std::vector<Func<void(const T&)>> onReady;
+        std::size_t bytes{0}, lastUse{0};
+    };
+
+    inline explicit ResourceHandle(SPtr<Entry> entry) noexcept : m_Entry{std::move(entry)} { }
+
+    SPtr<Entry> m_Entry;
+};
+
+// Resources of one type keyed by path. The first load of a path queues its decode on the decoder thread;
+// later loads of the same path share the entry. Entries without handles stay cached until evict() needs
+// their memory.
+template <typename T>
+class ResourcePool
+{
+public:
+    using Handle = ResourceHandle<T>;
+    using OnReady = Func<void(const T&)>;
+
+    // Decodes hold on to their entries, not to the pool
+    inline explicit ResourcePool(ResourceDecoder& decoder) noexcept : m_Decoder(decoder) { }
+
+    ResourcePool(const ResourcePool&) = delete;
+    ResourcePool& operator=(const ResourcePool&) = delete;
+
+    // `onReady` is called on the main thread once the resource is ready, right away if it already is.
+    // It isn't called if loading fails.
+    inline Handle load(const std::string& path, OnReady onReady = nullptr)
+    {
+        auto& entry(m_Entries[path]);
+        if (entry != nullptr)
+        {
+            m_Hits++;
+            entry->lastUse = ++m_UseCounter;
+            if (onReady != nullptr)
+            {
+                if (entry->state == ResourceState::Ready) onReady(entry->resource);
+                else if (entry->state == ResourceState::Loading) entry->onReady.emplace_back(std::move(onReady));
+            }
+            return Handle{entry};
+        }
+
+        m_Misses++;
+        entry = mkSPtr<typename Handle::Entry>();
+        entry->path = path;
+        entry->lastUse = ++m_UseCounter;
+        if (onReady != nullptr) entry->onReady.emplace_back(std::move(onReady));
+        m_Pending.emplace_back(entry);
+
+        m_Decoder.submit([entry]()
+        {
+            TRACE_SCOPE("ResourcePool::decode");
+            entry->decodeSucceeded = ResourceLoader<T>::decode(entry->path, entry->staging, entry->resource);
+            entry->decoded.store(true, std::memory_order_release);
+        });
+        return Handle{entry};
+    }
+
+    // Finalizes the decoded resources and calls their callbacks; returns how many were finished
+    inline std::size_t finalize()
+    {
+        std::size_t finished{0};
+        for (std::size_t i(0); i < m_Pending.size();)
+        {
+            auto entry(m_Pending[i]);
+            if (!entry->decoded.load(std::memory_order_acquire))
+            {
+                ++i;
+                continue;
+            }
+
+            m_Pending[i] = std::move(m_Pending.back());
+            m_Pending.pop_back();
+            finished++;
+
+            if (entry->decodeSucceeded && ResourceLoader<T>::finalize(entry->staging, entry->resource))
+            {
+                entry->state = ResourceState::Ready;
+                entry->bytes = ResourceLoader<T>::getSize(entry->resource, entry->staging);
+                m_Bytes += entry->bytes;
+                for (const auto& onReady : entry->onReady) onReady(entry->resource);
+            }
+            else
+            {
+                // Failed entries stay cached, so the same broken path isn't retried on every load
+                entry->state = ResourceState::Failed;
+                m_Failures++;
+                std::cerr << "Couldn't load " << entry->path << std::endl;
+            }
+            entry->onReady.clear();
+        }
+        return finished;
+    }
+
+    // Blocks until every queued resource is decoded, then finalizes them
+    inline void waitAll()
+    {
+        m_Decoder.wait();
+        finalize();
+    }
+
+    // Drops unreferenced resources, least recently loaded first, until at most `budget` bytes are resident.
+    // Returns the bytes freed.
+    inline std::size_t evict(std::size_t budget)
+    {
+        std::vector<typename decltype(m_Entries)::iterator> unused;
+        for (auto it(m_Entries.begin()); it != m_Entries.end(); ++it)
+            if (it->second.use_count() == 1 && it->second->state != ResourceState::Loading) unused.emplace_back(it);
+        std::sort(unused.begin(), unused.end(), [](const auto& a, const auto& b) { return a->second->lastUse < b->second->lastUse; });
+
+        const auto before(m_Bytes);
+        for (const auto& it : unused)
+        {
+            if (m_Bytes <= budget) break;
+            m_Bytes -= it->second->bytes;
+            m_Entries.erase(it);
+            m_Evictions++;
+        }
+        return before - m_Bytes;
+    }
+
+    inline std::size_t getResourceCount() const noexcept { return m_Entries.size(); }
+    inline std::size_t getPendingCount() const noexcept { return m_Pending.size(); }
+    inline std::size_t getBytes() const noexcept { return m_Bytes; }
+
+    // Totals: loads served from the cache, loads that had to decode, failed loads and evicted resources
+    inline std::size_t getHitCount() const noexcept { return m_Hits; }
+    inline std::size_t getMissCount() const noexcept { return m_Misses; }
+    inline std::size_t getFailureCount() const noexcept { return m_Failures; }
+    inline std::size_t getEvictionCount() const noexcept { return m_Evictions; }
+
+private:
+    ResourceDecoder& m_Decoder;
+    std::unordered_map<std::string, SPtr<typename Handle::Entry>> m_Entries;
+    std::vector<SPtr<typename Handle::Entry>> m_Pending;
+    std::size_t m_UseCounter{0}, m_Bytes{0};
+    std::size_t m_Hits{0}, m_Misses{0}, m_Failures{0}, m_Evictions{0};
+};
+
+using TextureHandle = ResourceHandle<sf::Texture>;
+using FontHandle = ResourceHandle<sf::Font>;
+
+// Textures and fonts shared by everything in a game, see GameBase::getResources. Loading, finalizing and
+// eviction happen on the main thread; only the decoding runs on the cache's decoder thread.
+class ResourceCache
+{
+public:
+    // Unreferenced resources are kept until the cache outgrows this many bytes
+    static constexpr std::size_t defaultBudget{64 * 1024 * 1024};
+
+    inline ResourceCache() : m_Textures{m_Decoder}, m_Fonts{m_Decoder} { }
+
+    inline TextureHandle loadTexture(const std::string& path, ResourcePool<sf::Texture>::OnReady onReady = nullptr)
+    {
+        return m_Textures.load(path, std::move(onReady));
+    }
+
+    inline FontHandle loadFont(const std::string& path, ResourcePool<sf::Font>::OnReady onReady = nullptr)
+    {
+        return m_Fonts.load(path, std::move(onReady));
+    }
+
+    // Called by the game loop once per frame: finishes what was decoded since and evicts beyond the budget
+    inline void finalize()
+    {
+        if (m_Textures.getPendingCount() + m_Fonts.getPendingCount() > 0)
+        {
+            TRACE_SCOPE("ResourceCache::finalize");
+            m_Textures.finalize();
+            m_Fonts.finalize();
+        }
+        if (getBytes() > m_Budget) evict(m_Budget);
+    }
+
+    // For loading screens and headless runs that need everything at once
+    inline void waitAll()
+    {
+        m_Textures.waitAll();
+        m_Fonts.waitAll();
+    }
+
+    // Textures go first, they're the larger ones
+    inline std::size_t evict(std::size_t budget)
+    {
+        const auto fontBytes(m_Fonts.getBytes());
+        auto freed(m_Textures.evict(budget > fontBytes ? budget - fontBytes : 0));
+        freed += m_Fonts.evict(budget > m_Textures.getBytes() ? budget - m_Textures.getBytes() : 0);
+        return freed;
+    }
+
+    inline void setBudget(std::size_t bytes) noexcept { m_Budget = bytes; }
+    inline std::size_t getBudget() const noexcept { return m_Budget; }
+    inline std::size_t getBytes() const noexcept { return m_Textures.getBytes() + m_Fonts.getBytes(); }
+
+    inline ResourcePool<sf::Texture>& getTextures() noexcept { return m_Textures; }
+    inline ResourcePool<sf::Font>& getFonts() noexcept { return m_Fonts; }
+
+private:
+    ResourceDecoder m_Decoder;
+    ResourcePool<sf::Texture> m_Textures;
+    ResourcePool<sf::Font> m_Fonts;
+    std::size_t m_Budget{defaultBudget};
+};
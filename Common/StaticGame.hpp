@@ -0,0 +1,49 @@
+#pragma once
+
+// Game loop with compile-time hook dispatch (CRTP).
+// TDerived implements any of
+//     loadContent(), handleEvent(const sf::Event&), update(float), updateVariable(float),
+//     publish(), draw(sf::RenderTarget&, float alpha), fpsUpdated(int)
+// and the loop calls them directly, so they can be inlined; hooks it doesn't implement fall back to the
+// empty ones below. If the hooks are private, TDerived has to declare `friend class StaticGame<TDerived>;`.
+template <typename TDerived>
+class StaticGame : public GameBase
+{
+public:
+    inline void run() { runLoop(*this); }
+
+    inline RunStats runHeadless(std::size_t tickCount, HeadlessDraw drawMode = HeadlessDraw::Skip)
+    {
+        return runHeadlessLoop(*this, tickCount, drawMode);
+    }
+
+    inline int run(int argc, char* argv[]) { return runFromArgs(*this, argc, argv); }
+
+protected:
+    inline StaticGame(const std::string& windowTitle, unsigned int windowWidth = 1024, unsigned int windowHeight = 768) noexcept
+        : GameBase{windowTitle, windowWidth, windowHeight}
+    {
+    }
+
+    inline void loadContent() { }
+    inline void handleEvent(const sf::Event&) { }
+    inline void update(float) { }
+    inline void updateVariable(float) { }
+    inline void publish() { }
+    inline void draw(sf::RenderTarget&, float) { }
+    inline void fpsUpdated(int) { }
+
+private:
+    friend class GameBase;
+
+    inline TDerived& derived() noexcept { return static_cast<TDerived&>(*this); }
+
+    inline void invokeLoadContent() { derived().loadContent(); }
+    inline void invokeEvent(const sf::Event& event) { derived().handleEvent(event); }
+    inline void invokeUpdate(float ft) { derived().update(ft); }
+    inline void invokeUpdateVariable(float dt) { derived().updateVariable(dt); }
+    inline void invokePublish() { derived().publish(); }
+    inline bool hasPublish() const noexcept { return !std::is_same<decltype(&TDerived::publish), void (StaticGame::*)()>::value; }
+    inline void invokeDraw(sf::RenderTarget& target, float alpha) { derived().draw(target, alpha); }
+    inline void invokeFpsUpdated(int fps) { derived().fpsUpdated(fps); }
+};
\ No newline at end of file
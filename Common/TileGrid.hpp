@@ -0,0 +1,324 @@
+#pragma once
+
+// Result of a TileGrid raycast or sweep
+struct TileHit
+{
+    bool hit{false};
+    float t{0.f};       // Distance along the ray, or fraction of the sweep
+    Vec2f point;        // Ray: where it enters the tile. Sweep: the circle's center at the time of impact.
+    Vec2f normal;       // Surface normal at the hit; zero if the query started inside a solid tile
+    Vec2i tile{-1, -1};
+};
+
+// Solidity of every tile of a grid map, one byte per tile, in world coordinates: tile (x, y) covers
+// [x * tileSize.x, (x + 1) * tileSize.x) horizontally, likewise vertically. Everything outside the grid is empty.
+// Queries only look at the tiles a shape can touch, so their cost depends on the shape's size, not the map's.
+class TileGrid
+{
+public:
+    // Every tile empty
+    inline void reset(unsigned int width, unsigned int height, Vec2f tileSize)
+    {
+        m_Width = width;
+        m_Height = height;
+        m_TileSize = tileSize;
+        m_InvTileSize = {1.f / tileSize.x, 1.f / tileSize.y};
+        m_Solid.assign(static_cast<std::size_t>(width) * height, 0);
+    }
+
+    // isSolid(id) decides for every tile id
+    template <typename TIsSolid>
+    inline void build(const std::uint16_t* tiles, unsigned int width, unsigned int height, Vec2f tileSize, TIsSolid&& isSolid)
+    {
+        reset(width, height, tileSize);
+        for (std::size_t i(0); i < m_Solid.size(); ++i) m_Solid[i] = isSolid(tiles[i]) ? 1 : 0;
+    }
+
+    inline void setSolid(unsigned int x, unsigned int y, bool solid) noexcept
+    {
+        assert(x < m_Width && y < m_Height);
+        m_Solid[static_cast<std::size_t>(y) * m_Width + x] = solid ? 1 : 0;
+    }
+
+    inline bool isSolid(int x, int y) const noexcept
+    {
+        return x >= 0 && y >= 0 && x < static_cast<int>(m_Width) && y < static_cast<int>(m_Height)
+            && m_Solid[static_cast<std::size_t>(y) * m_Width + x] != 0;
+    }
+
+    inline unsigned int getWidth() const noexcept { return m_Width; }
+    inline unsigned int getHeight() const noexcept { return m_Height; }
+    inline Vec2f getTileSize() const noexcept { return m_TileSize; }
+    inline Vec2i getTileAt(Vec2f point) const noexcept
+    {
+        return {static_cast<int>(std::floor(point.x * m_InvTileSize.x)), static_cast<int>(std::floor(point.y * m_InvTileSize.y))};
+    }
+
+    // Whether the box overlaps a solid tile; touching edges don't count
+    inline bool overlaps(const sf::FloatRect& box) const noexcept
+    {
+        const auto range(getTileRange(box.left, box.top, box.left + box.width, box.top + box.height));
+        for (auto y(range.top); y <= range.bottom; ++y)
+            for (auto x(range.left); x <= range.right; ++x)
+                if (isSolid(x, y)) return true;
+        return false;
+    }
+
+    inline bool overlapsCircle(Vec2f center, float radius) const noexcept
+    {
+        const auto range(getTileRange(center.x - radius, center.y - radius, center.x + radius, center.y + radius));
+        for (auto y(range.top); y <= range.bottom; ++y)
+            for (auto x(range.left); x <= range.right; ++x)
+                if (isSolid(x, y) && getLengthSquared(center - closestPoint(center, x, y)) < radius * radius) return true;
+        return false;
+    }
+
+    // Moves the circle out of every solid tile it overlaps, one tile after the other. Returns false if it
+    // overlapped none; otherwise `normal` is the normalized sum of the push directions.
+    inline bool pushOutCircle(Vec2f& center, float radius, Vec2f& normal) const noexcept
+    {
+        // A push can move the circle onto tiles outside the range it started from, so the range is taken again
+        // until a pass pushes nothing; the passes are capped, as tight gaps can push the circle back and forth
+        static constexpr int maxPasses{4};
+        Vec2f pushed;
+        for (auto pass(0); pass < maxPasses; ++pass)
+        {
+            auto moved(false);
+            const auto range(getTileRange(center.x - radius, center.y - radius, center.x + radius, center.y + radius));
+            for (auto y(range.top); y <= range.bottom; ++y)
+            {
+                for (auto x(range.left); x <= range.right; ++x)
+                {
+                    if (!isSolid(x, y)) continue;
+
+                    const auto delta(center - closestPoint(center, x, y));
+                    const auto distanceSquared(getLengthSquared(delta));
+                    if (distanceSquared >= radius * radius) continue;
+
+                    Vec2f direction;
+                    auto depth(0.f);
+                    if (distanceSquared > 0.f)
+                    {
+                        const auto distance(std::sqrt(distanceSquared));
+                        direction = delta / distance;
+                        depth = radius - distance;
+                    }
+                    else depth = getEscape(center, x, y, direction) + radius;
+
+                    center += direction * depth;
+                    pushed += direction;
+                    moved = true;
+                }
+            }
+            if (!moved) break;
+        }
+
+        const auto length(std::sqrt(getLengthSquared(pushed)));
+        if (length == 0.f) return false;
+        normal = pushed / length;
+        return true;
+    }
+
+    // Walks the tiles along the ray (Amanatides-Woo DDA) up to `maxDistance`; `direction` needn't be normalized.
+    // t is the distance to the first solid tile.
+    inline TileHit raycast(Vec2f origin, Vec2f direction, float maxDistance) const noexcept
+    {
+        TileHit result;
+        const auto length(std::sqrt(getLengthSquared(direction)));
+        if (length == 0.f) return result;
+        direction /= length;
+
+        auto tile(getTileAt(origin));
+        if (isSolid(tile.x, tile.y))
+        {
+            result.hit = true;
+            result.point = origin;
+            result.tile = tile;
+            return result;
+        }
+
+        // Distance to the next vertical and horizontal grid line, and between two of them
+        static constexpr float infinity{std::numeric_limits<float>::infinity()};
+        const auto stepX(direction.x > 0.f ? 1 : -1), stepY(direction.y > 0.f ? 1 : -1);
+        const auto deltaX(direction.x != 0.f ? m_TileSize.x / std::abs(direction.x) : infinity);
+        const auto deltaY(direction.y != 0.f ? m_TileSize.y / std::abs(direction.y) : infinity);
+        auto nextX(direction.x != 0.f ? ((tile.x + (stepX > 0 ? 1 : 0)) * m_TileSize.x - origin.x) / direction.x : infinity);
+        auto nextY(direction.y != 0.f ? ((tile.y + (stepY > 0 ? 1 : 0)) * m_TileSize.y - origin.y) / direction.y : infinity);
+
+        const auto width(static_cast<int>(m_Width)), height(static_cast<int>(m_Height));
+        while (true)
+        {
+            auto distance(0.f);
+            if (nextX < nextY)
+            {
+                distance = nextX;
+                nextX += deltaX;
+                tile.x += stepX;
+                result.normal = {static_cast<float>(-stepX), 0.f};
+            }
+            else
+            {
+                distance = nextY;
+                nextY += deltaY;
+                tile.y += stepY;
+                result.normal = {0.f, static_cast<float>(-stepY)};
+            }
+
+            // Past the range, or off the grid and moving away from it
+            if (distance > maxDistance || (tile.x < 0 && stepX < 0) || (tile.x >= width && stepX > 0)
+                || (tile.y < 0 && stepY < 0) || (tile.y >= height && stepY > 0)) break;
+
+            if (isSolid(tile.x, tile.y))
+            {
+                result.hit = true;
+                result.t = distance;
+                result.point = origin + direction * distance;
+                result.tile = tile;
+                return result;
+            }
+        }
+
+        result.normal = {};
+        return result;
+    }
+
+    // First contact of a circle moving from `from` to `to` with a solid tile; t is the fraction of the move.
+    // A circle that already overlaps a tile hits it at t = 0.
+    inline TileHit sweepCircle(Vec2f from, Vec2f to, float radius) const noexcept
+    {
+        TileHit result;
+        result.t = 1.f;
+
+        const auto move(to - from);
+        const auto range(getTileRange(std::min(from.x, to.x) - radius, std::min(from.y, to.y) - radius,
+            std::max(from.x, to.x) + radius, std::max(from.y, to.y) + radius));
+        for (auto y(range.top); y <= range.bottom; ++y)
+        {
+            for (auto x(range.left); x <= range.right; ++x)
+            {
+                auto t(0.f);
+                Vec2f normal;
+                if (!isSolid(x, y) || !sweepCircleTile(from, move, radius, x, y, t, normal) || (result.hit && t >= result.t)) continue;
+
+                result.hit = true;
+                result.t = t;
+                result.normal = normal;
+                result.tile = {x, y};
+            }
+        }
+
+        result.point = from + move * result.t;
+        return result;
+    }
+
+private:
+    struct TileRange
+    {
+        int left, top, right, bottom;   // Inclusive
+    };
+
+    inline static float getLengthSquared(Vec2f v) noexcept { return v.x * v.x + v.y * v.y; }
+
+    // Tiles the box (open on the right and bottom) touches, clamped to the grid
+    inline TileRange getTileRange(float left, float top, float right, float bottom) const noexcept
+    {
+        const auto clampX([this](float x) { return static_cast<int>(std::min(std::max(x, -1.f), static_cast<float>(m_Width))); });
+        const auto clampY([this](float y) { return static_cast<int>(std::min(std::max(y, -1.f), static_cast<float>(m_Height))); });
+        return {clampX(std::floor(left * m_InvTileSize.x)), clampY(std::floor(top * m_InvTileSize.y)),
+            clampX(std::ceil(right * m_InvTileSize.x) - 1.f), clampY(std::ceil(bottom * m_InvTileSize.y) - 1.f)};
+    }
+
+    inline Vec2f getTileMin(int x, int y) const noexcept { return {x * m_TileSize.x, y * m_TileSize.y}; }
+
+    inline Vec2f closestPoint(Vec2f p, int x, int y) const noexcept
+    {
+        const auto min(getTileMin(x, y));
+        return {std::min(std::max(p.x, min.x), min.x + m_TileSize.x), std::min(std::max(p.y, min.y), min.y + m_TileSize.y)};
+    }
+
+    // For a point inside tile (x, y): the shortest way out through a side without a solid neighbor (any side
+    // if all four have one). Returns the distance to that side.
+    inline float getEscape(Vec2f p, int x, int y, Vec2f& direction) const noexcept
+    {
+        const auto min(getTileMin(x, y));
+        const std::array<float, 4> distances{{p.x - min.x, min.x + m_TileSize.x - p.x, p.y - min.y, min.y + m_TileSize.y - p.y}};
+        const std::array<Vec2i, 4> sides{{{-1, 0}, {1, 0}, {0, -1}, {0, 1}}};
+
+        auto best(-1);
+        for (auto open : {true, false})
+        {
+            for (auto i(0); i < 4; ++i)
+            {
+                if (open && isSolid(x + sides[i].x, y + sides[i].y)) continue;
+                if (best < 0 || distances[i] < distances[best]) best = i;
+            }
+            if (best >= 0) break;
+        }
+
+        direction = {static_cast<float>(sides[best].x), static_cast<float>(sides[best].y)};
+        return distances[best];
+    }
+
+    // Time of impact in [0, 1] of a circle moving from p by d with tile (x, y): a ray against the tile grown
+    // by the radius, with rounded corners
+    inline bool sweepCircleTile(Vec2f p, Vec2f d, float r, int x, int y, float& t, Vec2f& normal) const noexcept
+    {
+        const auto min(getTileMin(x, y)), max(min + m_TileSize);
+
+        const auto closest(closestPoint(p, x, y));
+        const auto startDelta(p - closest);
+        if (getLengthSquared(startDelta) < r * r)
+        {
+            const auto length(std::sqrt(getLengthSquared(startDelta)));
+            t = 0.f;
+            normal = length > 0.f ? startDelta / length : Vec2f{};
+            return true;
+        }
+
+        // Slab test against the box grown by r
+        auto enter(0.f), exit(1.f);
+        const std::array<float, 2> start{{p.x, p.y}}, delta{{d.x, d.y}}, lo{{min.x - r, min.y - r}}, hi{{max.x + r, max.y + r}};
+        for (auto axis(0); axis < 2; ++axis)
+        {
+            if (delta[axis] == 0.f)
+            {
+                if (start[axis] < lo[axis] || start[axis] > hi[axis]) return false;
+                continue;
+            }
+
+            auto t0((lo[axis] - start[axis]) / delta[axis]), t1((hi[axis] - start[axis]) / delta[axis]);
+            if (t0 > t1) std::swap(t0, t1);
+            if (t0 > enter)
+            {
+                enter = t0;
+                normal = axis == 0 ? Vec2f{delta[0] > 0.f ? -1.f : 1.f, 0.f} : Vec2f{0.f, delta[1] > 0.f ? -1.f : 1.f};
+            }
+            exit = std::min(exit, t1);
+            if (enter > exit) return false;
+        }
+
+        // Entering through a corner region of the grown box: the rounded corner decides
+        const auto hit(p + d * enter);
+        if ((hit.x < min.x || hit.x > max.x) && (hit.y < min.y || hit.y > max.y))
+        {
+            const Vec2f corner{hit.x < min.x ? min.x : max.x, hit.y < min.y ? min.y : max.y};
+            const auto m(p - corner);
+            const auto a(getLengthSquared(d)), b(m.x * d.x + m.y * d.y), c(getLengthSquared(m) - r * r);
+            const auto discriminant(b * b - a * c);
+            if (a == 0.f || discriminant < 0.f) return false;
+
+            const auto tc((-b - std::sqrt(discriminant)) / a);
+            if (tc < 0.f || tc > 1.f) return false;
+            t = tc;
+            normal = (p + d * tc - corner) / r;
+            return true;
+        }
+
+        t = enter;
+        return true;
+    }
+
+    unsigned int m_Width{0}, m_Height{0};
+    Vec2f m_TileSize{1.f, 1.f}, m_InvTileSize{1.f, 1.f};
+    std::vector<std::uint8_t> m_Solid;
+};
@@ -0,0 +1,237 @@
+#pragma once
+
+// Scoped timing events that can be exported in the Chrome trace format (chrome://tracing or ui.perfetto.dev).
+//
+//     TRACE_SCOPE("broadphase");
+//
+// records the time from that line to the end of the enclosing scope. Names must be string literals (only the
+// pointer is stored). Every recording thread writes into its own fixed-size ring buffer without locking; once a
+// buffer is full the oldest events are overwritten. Recording is off until Tracer::setEnabled(true), and defining
+// DISABLE_TRACE compiles every TRACE_SCOPE out.
+
+struct TraceEvent
+{
+    const char* name;
+    HRClock::time_point begin, end;
+    std::uint32_t threadId;
+};
+
+// Single-producer ring buffer: only the owning thread pushes. Every slot is stamped with the index of the event
+// it holds, written last; a reader that sees the same stamp before and after copying a slot got the whole
+// event, so the buffer can be exported while its owner keeps recording.
+class TraceBuffer
+{
+public:
+    static constexpr std::size_t capacity{1 << 16};
+
+    inline TraceBuffer() : m_Slots{new Slot[capacity]} { }
+
+    inline void push(std::uint32_t threadId, const char* name, HRClock::time_point begin, HRClock::time_point end) noexcept
+    {
+        const auto head(m_Head.load(std::memory_order_relaxed));
+        auto& slot(m_Slots[head % capacity]);
+        slot.stamp.store(emptyStamp, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.name.store(name, std::memory_order_relaxed);
+        slot.begin.store(begin.time_since_epoch().count(), std::memory_order_relaxed);
+        slot.end.store(end.time_since_epoch().count(), std::memory_order_relaxed);
+        slot.threadId.store(threadId, std::memory_order_relaxed);
+        slot.stamp.store(head, std::memory_order_release);
+        m_Head.store(head + 1, std::memory_order_release);
+    }
+
+    // Calls fn(event) for every event still in the buffer, oldest first. Slots the owner overwrites in the
+    // meantime are skipped.
+    template <typename TFunc>
+    inline void forEach(TFunc&& fn) const
+    {
+        const auto head(m_Head.load(std::memory_order_acquire));
+        for (auto i(head > capacity ? head - capacity : 0); i < head; ++i)
+        {
+            const auto& slot(m_Slots[i % capacity]);
+            if (slot.stamp.load(std::memory_order_acquire) != i) continue;
+
+            const TraceEvent event{slot.name.load(std::memory_order_relaxed),
+                HRClock::time_point{HRClock::duration{slot.begin.load(std::memory_order_relaxed)}},
+                HRClock::time_point{HRClock::duration{slot.end.load(std::memory_order_relaxed)}},
+                slot.threadId.load(std::memory_order_relaxed)};
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.stamp.load(std::memory_order_relaxed) == i) fn(event);
+        }
+    }
+
+private:
+    static constexpr std::size_t emptyStamp{std::numeric_limits<std::size_t>::max()};
+
+    struct Slot
+    {
+        std::atomic<std::size_t> stamp{emptyStamp};
+        std::atomic<const char*> name{nullptr};
+        std::atomic<HRClock::rep> begin{0}, end{0};
+        std::atomic<std::uint32_t> threadId{0};
+    };
+
+    UPtr<Slot[]> m_Slots;
+    std::atomic<std::size_t> m_Head{0};
+};
+
+// Process-wide registry of the thread names and the ring buffers
+class Tracer
+{
+public:
+    inline static Tracer& get()
+    {
+        static Tracer instance;
+        return instance;
+    }
+
+    inline void setEnabled(bool enabled) noexcept { m_Enabled.store(enabled, std::memory_order_relaxed); }
+    inline bool isEnabled() const noexcept { return m_Enabled.load(std::memory_order_relaxed); }
+
+    // Name shown for the calling thread in the trace viewer. Only takes a slot in the name table, the thread's
+    // buffer is created once it records its first event.
+    inline void setThreadName(const std::string& name)
+    {
+        const auto id(getLocalThread().id);
+        std::lock_guard<std::mutex> lock{m_Mutex};
+        m_ThreadNames[id - 1] = name;
+    }
+
+    inline void record(const char* name, HRClock::time_point begin, HRClock::time_point end)
+    {
+        if (!isEnabled()) return;
+
+        auto& thread(getLocalThread());
+        if (thread.buffer == nullptr) thread.buffer = acquireBuffer();
+        thread.buffer->push(thread.id, name, begin, end);
+    }
+
+    // Writes every recorded event as a Chrome trace JSON document
+    inline void writeChromeTrace(std::ostream& os) const
+    {
+        std::lock_guard<std::mutex> lock{m_Mutex};
+
+        os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n" << std::fixed << std::setprecision(3);
+        auto first(true);
+        const auto separate([&os, &first]() { if (!first) os << ",\n"; first = false; });
+
+        for (std::size_t i(0); i < m_ThreadNames.size(); ++i)
+        {
+            separate();
+            os << R"({"name":"thread_name","ph":"M","pid":1,"tid":)" << i + 1 << R"(,"args":{"name":")" << m_ThreadNames[i] << "\"}}";
+        }
+
+        for (const auto& buffer : m_Buffers)
+        {
+            buffer->forEach([this, &os, &separate](const TraceEvent& e)
+            {
+                separate();
+                os << R"({"name":")" << e.name << R"(","ph":"X","pid":1,"tid":)" << e.threadId
+                   << ",\"ts\":" << toUs(e.begin - m_Epoch) << ",\"dur\":" << toUs(e.end - e.begin) << "}";
+            });
+        }
+
+        os << "\n]}\n";
+    }
+
+    // Writes the trace to `path`; returns false if the file couldn't be opened
+    inline bool dump(const std::string& path) const
+    {
+        std::ofstream file{path};
+        if (!file) return false;
+        writeChromeTrace(file);
+        return static_cast<bool>(file);
+    }
+
+private:
+    // Hands the thread's buffer back when the thread exits
+    struct LocalThread
+    {
+        std::uint32_t id{0};
+        TraceBuffer* buffer{nullptr};
+
+        inline ~LocalThread()
+        {
+            if (buffer != nullptr) Tracer::get().releaseBuffer(buffer);
+        }
+    };
+
+    inline Tracer() = default;
+
+    inline static double toUs(HRClock::duration d) noexcept
+    {
+        return std::chrono::duration<double, std::micro>(d).count();
+    }
+
+    inline LocalThread& getLocalThread()
+    {
+        static thread_local LocalThread thread;
+        if (thread.id == 0)
+        {
+            std::lock_guard<std::mutex> lock{m_Mutex};
+            m_ThreadNames.emplace_back("thread " + std::to_string(m_ThreadNames.size() + 1));
+            thread.id = static_cast<std::uint32_t>(m_ThreadNames.size());
+        }
+        return thread;
+    }
+
+    // Buffers of finished threads are reused, so there are only as many as threads ever recorded at once.
+    // Until a new thread overwrites them, their events are still exported; every event carries its thread id.
+    inline TraceBuffer* acquireBuffer()
+    {
+        std::lock_guard<std::mutex> lock{m_Mutex};
+        if (!m_FreeBuffers.empty())
+        {
+            const auto buffer(m_FreeBuffers.back());
+            m_FreeBuffers.pop_back();
+            return buffer;
+        }
+        m_Buffers.emplace_back(mkUPtr<TraceBuffer>());
+        return m_Buffers.back().get();
+    }
+
+    inline void releaseBuffer(TraceBuffer* buffer)
+    {
+        std::lock_guard<std::mutex> lock{m_Mutex};
+        m_FreeBuffers.emplace_back(buffer);
+    }
+
+    std::atomic<bool> m_Enabled{false};
+    HRClock::time_point m_Epoch{HRClock::now()};
+    mutable std::mutex m_Mutex;
+    std::vector<UPtr<TraceBuffer>> m_Buffers;
+    std::vector<TraceBuffer*> m_FreeBuffers;
+    std::vector<std::string> m_ThreadNames;     // Indexed by thread id - 1
+};
+
+// Records the lifetime of the object as one trace event
+class TraceScope
+{
+public:
+    inline explicit TraceScope(const char* name) noexcept
+        : m_Name{Tracer::get().isEnabled() ? name : nullptr},
+          m_Begin{m_Name != nullptr ? HRClock::now() : HRClock::time_point{}}
+    {
+    }
+
+    inline ~TraceScope()
+    {
+        if (m_Name != nullptr) Tracer::get().record(m_Name, m_Begin, HRClock::now());
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* m_Name;
+    HRClock::time_point m_Begin;
+};
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+
+#ifdef DISABLE_TRACE
+#define TRACE_SCOPE(name) do { } while (false)
+#else
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__){name}
+#endif
\ No newline at end of file
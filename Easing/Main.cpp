@@ -305,7 +305,7 @@ public:
         {
             updateVariable(dt);
         };
-        m_Game.onDraw = [this](sf::RenderTarget& target)
+        m_Game.onDraw = [this](sf::RenderTarget& target, float)
         {
             draw(target);
         };
@@ -330,9 +330,9 @@ public:
         };
     }
 
-    inline void run()
+    inline int run(int argc, char* argv[])
     {
-        m_Game.run();
+        return m_Game.run(argc, argv);
     }
 
 private:
@@ -341,14 +341,16 @@ private:
         const auto windowWidth(m_Game.getWindowWidth());
         const auto windowHeight(m_Game.getWindowHeight());
 
-        m_TxScoreboard.loadFromFile("assets/scoreboard.png");
+        m_TxScoreboard = m_Game.getResources().loadTexture("Assets/Scoreboard.png", [this](const sf::Texture& texture)
+        {
+            m_Scoreboard.setTexture(texture);
+        });
 
         m_Shape.setPosition(windowWidth/2.f, windowHeight/2.f);
         m_Shape.setSize({m_Width, m_Height});
         m_Shape.setOrigin(m_Width/2.f, m_Height/2.f);
         m_Shape.setFillColor(sf::Color::Black);
 
-        m_Scoreboard.setTexture(m_TxScoreboard);
         m_Scoreboard.setPosition(windowWidth / 2.f + 480 / 2.f - 250.f, m_ScoreY);
 
     }
@@ -443,7 +445,7 @@ private:
 
     Game m_Game{"SFML easing", windowWidth, windowHeight};
 
-    sf::Texture m_TxScoreboard;
+    TextureHandle m_TxScoreboard;
 
     sf::RectangleShape m_Shape;
     sf::Sprite m_Scoreboard;
@@ -460,8 +462,7 @@ private:
     EasingState m_EasingState{EasingState::None};
 };
 
-int main()
+int main(int argc, char* argv[])
 {
-    TransGame{}.run();
-    return 0;
+    return TransGame{}.run(argc, argv);
 }
\ No newline at end of file
@@ -0,0 +1,91 @@
+#include "../Common/Common.hpp"
+
+// Measures the per-tick overhead of Game's std::function hooks against StaticGame's compile-time hooks.
+// Both variants run the same trivial update headless, with the profiler off, so the difference is the dispatch.
+// Usage: GameBench [ticks] [repeats]
+
+struct Counter
+{
+    float elapsed{0.f};
+    std::size_t ticks{0};
+
+    inline void tick(float ft) noexcept
+    {
+        elapsed += ft;
+        ++ticks;
+    }
+};
+
+class FuncGameBench
+{
+public:
+    inline FuncGameBench()
+    {
+        m_Game.onUpdate = [this](float ft)
+        {
+            m_Counter.tick(ft);
+        };
+        m_Game.getProfiler().setEnabled(false);
+    }
+
+    inline RunStats run(std::size_t tickCount) { return m_Game.runHeadless(tickCount); }
+    inline const Counter& getCounter() const noexcept { return m_Counter; }
+
+private:
+    Game m_Game{"Game"};
+    Counter m_Counter;
+};
+
+class StaticGameBench : public StaticGame<StaticGameBench>
+{
+public:
+    inline StaticGameBench() : StaticGame{"StaticGame"}
+    {
+        getProfiler().setEnabled(false);
+    }
+
+    inline RunStats run(std::size_t tickCount) { return runHeadless(tickCount); }
+    inline const Counter& getCounter() const noexcept { return m_Counter; }
+
+private:
+    friend class StaticGame<StaticGameBench>;
+
+    inline void update(float ft) { m_Counter.tick(ft); }
+
+    Counter m_Counter;
+};
+
+// Runs a fresh instance of TBench `repeats` times and keeps the fastest run
+template <typename TBench>
+inline RunStats runBest(std::size_t tickCount, std::size_t repeats, float& checksum)
+{
+    RunStats best;
+    for (std::size_t i(0); i < repeats; ++i)
+    {
+        TBench bench;
+        const auto stats(bench.run(tickCount));
+        checksum += bench.getCounter().elapsed;
+        if (i == 0 || stats.elapsed < best.elapsed) best = stats;
+    }
+    return best;
+}
+
+int main(int argc, char* argv[])
+{
+    const std::size_t tickCount(argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000000);
+    const std::size_t repeats(argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 5);
+
+    auto checksum(0.f);
+    const auto funcStats(runBest<FuncGameBench>(tickCount, repeats, checksum));
+    const auto staticStats(runBest<StaticGameBench>(tickCount, repeats, checksum));
+
+    const auto funcNs(funcStats.getNsPerTick()), staticNs(staticStats.getNsPerTick());
+    std::cout << std::fixed << std::setprecision(3)
+              << "ticks: " << tickCount << ", best of " << repeats << "\n"
+              << "Game (std::function): " << funcNs << " ns/tick\n"
+              << "StaticGame (CRTP):    " << staticNs << " ns/tick\n"
+              << "overhead per tick:    " << funcNs - staticNs << " ns"
+              << " (" << (staticNs > 0.0 ? funcNs / staticNs : 0.0) << "x)\n"
+              << "checksum: " << checksum << std::endl;
+    return 0;
+}
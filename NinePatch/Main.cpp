@@ -13,7 +13,7 @@ public:
         {
             update(ft);
         };
-        m_Game.onDraw = [this](sf::RenderTarget& target)
+        m_Game.onDraw = [this](sf::RenderTarget& target, float)
         {
             draw(target);
         };
@@ -24,8 +24,10 @@ public:
 private:
     inline void loadContent()
     {
-        m_Texture.loadFromFile("Assets/ninepatch.png");
-        m_NinePatch.setTexture(m_Texture);
+        m_Texture = m_Game.getResources().loadTexture("Assets/ninepatch.png", [this](const sf::Texture& texture)
+        {
+            m_NinePatch.setTexture(texture);
+        });
     }
 
     inline void update(float ft)
@@ -42,7 +44,7 @@ private:
 
 private:
     Game m_Game{"Nine Patch"};
-    sf::Texture m_Texture;
+    TextureHandle m_Texture;
     NinePatch m_NinePatch;
 };
 
@@ -0,0 +1,131 @@
+#pragma once
+#include "../Common/Common.hpp"
+
+// Structure-of-arrays body storage: every component lives in its own contiguous array, so the update
+// streams through exactly the data it touches. prevX/prevY hold the positions before the last fixed
+// update, for interpolation when drawing.
+struct BodyStore
+{
+    std::vector<float> x, y, vx, vy, radius;
+    std::vector<float> prevX, prevY;
+
+    inline std::size_t size() const noexcept { return x.size(); }
+
+    inline void reserve(std::size_t count)
+    {
+        for (auto v : {&x, &y, &vx, &vy, &radius, &prevX, &prevY}) v->reserve(count);
+    }
+
+    inline void clear() noexcept
+    {
+        for (auto v : {&x, &y, &vx, &vy, &radius, &prevX, &prevY}) v->clear();
+    }
+
+    inline void resize(std::size_t count)
+    {
+        for (auto v : {&x, &y, &vx, &vy, &radius, &prevX, &prevY}) v->resize(count);
+    }
+
+    // Overwrites body `to` with body `from`, for swap-removing
+    inline void copy(std::size_t from, std::size_t to) noexcept
+    {
+        for (auto v : {&x, &y, &vx, &vy, &radius, &prevX, &prevY}) (*v)[to] = (*v)[from];
+    }
+
+    inline std::size_t getMemoryUsage() const noexcept
+    {
+        std::size_t bytes{0};
+        for (auto v : {&x, &y, &vx, &vy, &radius, &prevX, &prevY}) bytes += v->capacity() * sizeof(float);
+        return bytes;
+    }
+
+    // Returns the index of the new body
+    inline std::size_t add(float px, float py, float velX, float velY, float r)
+    {
+        x.emplace_back(px);
+        y.emplace_back(py);
+        vx.emplace_back(velX);
+        vy.emplace_back(velY);
+        radius.emplace_back(r);
+        prevX.emplace_back(px);
+        prevY.emplace_back(py);
+        return x.size() - 1;
+    }
+};
+
+// FNV-1a over the raw bits of the positions and velocities, for comparing runs
+inline std::uint64_t hashBodyState(const BodyStore& b)
+{
+    std::uint64_t hash{14695981039346656037ull};
+    for (auto v : {&b.x, &b.y, &b.vx, &b.vy})
+    {
+        const auto bytes(reinterpret_cast<const unsigned char*>(v->data()));
+        for (std::size_t i(0); i < v->size() * sizeof(float); ++i) hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+// Draws any number of circles in a single draw call: every circle is a quad textured with one
+// pre-rendered disc, tinted through the vertex color. setCircle() only writes its own four vertices,
+// so the quads can be filled from several threads.
+class CircleBatch : public sf::Drawable
+{
+public:
+    inline explicit CircleBatch(unsigned int discSize = 64) : m_DiscSize{discSize} { }
+
+    inline void setColor(sf::Color color) noexcept { m_Color = color; }
+
+    inline void resize(std::size_t circleCount)
+    {
+        if (!m_TextureReady) createTexture();
+        m_Vertices.resize(circleCount * 4);
+    }
+
+    inline std::size_t getCircleCount() const noexcept { return m_Vertices.size() / 4; }
+
+    inline void setCircle(std::size_t index, float x, float y, float r) noexcept { setCircle(index, x, y, r, m_Color); }
+
+    inline void setCircle(std::size_t index, float x, float y, float r, sf::Color color) noexcept
+    {
+        const auto size(static_cast<float>(m_DiscSize));
+        auto quad(&m_Vertices[index * 4]);
+        quad[0] = sf::Vertex{{x - r, y - r}, color, {0.f, 0.f}};
+        quad[1] = sf::Vertex{{x + r, y - r}, color, {size, 0.f}};
+        quad[2] = sf::Vertex{{x + r, y + r}, color, {size, size}};
+        quad[3] = sf::Vertex{{x - r, y + r}, color, {0.f, size}};
+    }
+
+private:
+    // Uploaded on first use, so headless runs that never draw don't need a GL context
+    inline void createTexture()
+    {
+        // White disc with a one texel anti-aliased edge; the color comes from the vertices
+        sf::Image disc;
+        disc.create(m_DiscSize, m_DiscSize, sf::Color::Transparent);
+        const auto center(m_DiscSize / 2.f), radius(m_DiscSize / 2.f);
+        for (unsigned int py(0); py < m_DiscSize; ++py)
+            for (unsigned int px(0); px < m_DiscSize; ++px)
+            {
+                const auto dx(px + .5f - center), dy(py + .5f - center);
+                const auto coverage(std::min(std::max(radius - std::sqrt(dx*dx + dy*dy), 0.f), 1.f));
+                disc.setPixel(px, py, sf::Color(255, 255, 255, static_cast<sf::Uint8>(coverage * 255)));
+            }
+
+        m_Texture.loadFromImage(disc);
+        m_Texture.setSmooth(true);
+        m_TextureReady = true;
+    }
+
+    inline void draw(sf::RenderTarget& target, sf::RenderStates states) const override
+    {
+        if (m_Vertices.empty()) return;
+        states.texture = &m_Texture;
+        target.draw(&m_Vertices[0], m_Vertices.size(), sf::Quads, states);
+    }
+
+    unsigned int m_DiscSize;
+    sf::Color m_Color{sf::Color::Black};
+    sf::Texture m_Texture;
+    bool m_TextureReady{false};
+    std::vector<sf::Vertex> m_Vertices;
+};
\ No newline at end of file
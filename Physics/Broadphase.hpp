@@ -0,0 +1,262 @@
+#pragma once
+#include "Bodies.hpp"
+
+// Two overlapping bodies, always with a < b
+struct BodyPair
+{
+    std::uint32_t a, b;
+};
+
+// Narrowphase shared by all broadphases
+inline void addPairIfOverlapping(const BodyStore& b, std::uint32_t i, std::uint32_t j, std::vector<BodyPair>& pairs)
+{
+    const auto dx(b.x[j] - b.x[i]), dy(b.y[j] - b.y[i]);
+    const auto r(b.radius[i] + b.radius[j]);
+    if (dx*dx + dy*dy < r*r) pairs.emplace_back(BodyPair{std::min(i, j), std::max(i, j)});
+}
+
+// Finds the overlapping pairs of a set of bodies. Implementations differ in which body distributions they
+// handle well, so PhysicsWorld can switch between them at runtime. The pair order has to be deterministic and
+// must not depend on the number of job system threads.
+class Broadphase
+{
+public:
+    virtual ~Broadphase() = default;
+
+    virtual const char* getName() const noexcept = 0;
+
+    // Replaces `out` with every overlapping pair
+    virtual void findPairs(const BodyStore& bodies, std::vector<BodyPair>& out, JobSystem* jobs) = 0;
+
+    // Bytes held by the broadphase's own structures
+    virtual std::size_t getMemoryUsage() const noexcept = 0;
+};
+
+// Uniform grid broadphase. Bodies are binned by their center with a counting sort each tick; with a cell
+// size of at least the largest body diameter, overlapping bodies always sit in the same or adjacent cells.
+// Each cell is then tested against itself and its right, lower-left, lower and lower-right neighbours, so
+// every candidate pair is visited exactly once. Only pairs that actually overlap are reported.
+// Best for dense scenes of similarly sized bodies.
+class UniformGrid : public Broadphase
+{
+public:
+    static constexpr std::size_t rowsPerJob{16};
+
+    inline UniformGrid(float width, float height, float cellSize) { setBounds(width, height, cellSize); }
+
+    inline void setBounds(float width, float height, float cellSize)
+    {
+        m_CellSize = cellSize;
+        m_InvCellSize = 1.f / cellSize;
+        m_Cols = std::max(1u, static_cast<unsigned int>(std::ceil(width / cellSize)));
+        m_Rows = std::max(1u, static_cast<unsigned int>(std::ceil(height / cellSize)));
+        m_CellStart.assign(m_Cols * m_Rows + 1, 0);
+    }
+
+    inline float getCellSize() const noexcept { return m_CellSize; }
+    inline std::size_t getCellCount() const noexcept { return m_Cols * m_Rows; }
+
+    // The cell of every body is computed in parallel if a job system is given; counting and scattering stay serial
+    inline void rebuild(const BodyStore& bodies, JobSystem* jobs = nullptr)
+    {
+        static constexpr std::size_t bodiesPerJob{4096};
+
+        const auto count(bodies.size());
+        m_CellOf.resize(count);
+        m_Sorted.resize(count);
+        std::fill(m_CellStart.begin(), m_CellStart.end(), 0);
+
+        const auto computeCells([this, &bodies](std::size_t first, std::size_t last)
+        {
+            for (auto i(first); i < last; ++i) m_CellOf[i] = getCell(bodies.x[i], bodies.y[i]);
+        });
+        if (jobs != nullptr) jobs->parallelFor(0, count, bodiesPerJob, computeCells);
+        else computeCells(0, count);
+
+        for (std::size_t i(0); i < count; ++i) ++m_CellStart[m_CellOf[i] + 1];
+
+        std::partial_sum(m_CellStart.begin(), m_CellStart.end(), m_CellStart.begin());
+
+        // Scatter in index order, so every cell lists its bodies in ascending order
+        m_Fill.assign(m_CellStart.begin(), m_CellStart.end() - 1);
+        for (std::size_t i(0); i < count; ++i) m_Sorted[m_Fill[m_CellOf[i]]++] = static_cast<std::uint32_t>(i);
+    }
+
+    inline const char* getName() const noexcept override { return "grid"; }
+
+    inline std::size_t getMemoryUsage() const noexcept override
+    {
+        auto bytes((m_CellStart.capacity() + m_Fill.capacity() + m_CellOf.capacity() + m_Sorted.capacity()) * sizeof(std::uint32_t));
+        for (const auto& pairs : m_BandPairs) bytes += pairs.capacity() * sizeof(BodyPair);
+        return bytes;
+    }
+
+    // Rebuilds the grid and reports the pairs in cell order. With a job system the rows are split into bands
+    // that are searched in parallel and concatenated afterwards, so the order doesn't depend on it.
+    inline void findPairs(const BodyStore& bodies, std::vector<BodyPair>& out, JobSystem* jobs) override
+    {
+        rebuild(bodies, jobs);
+
+        const auto bandCount((m_Rows + rowsPerJob - 1) / rowsPerJob);
+        m_BandPairs.resize(bandCount);
+
+        const auto findInRows([this, &bodies](std::size_t firstRow, std::size_t lastRow)
+        {
+            auto& pairs(m_BandPairs[firstRow / rowsPerJob]);
+            pairs.clear();
+            for (auto row(firstRow); row < lastRow; ++row)
+                for (unsigned int col(0); col < m_Cols; ++col) findPairsInCell(bodies, col, static_cast<unsigned int>(row), pairs);
+        });
+
+        // Band by band without one too, so no band keeps the pairs of an earlier call
+        if (jobs != nullptr) jobs->parallelFor(0, m_Rows, rowsPerJob, findInRows);
+        else for (std::size_t row(0); row < m_Rows; row += rowsPerJob) findInRows(row, std::min<std::size_t>(row + rowsPerJob, m_Rows));
+
+        out.clear();
+        for (const auto& pairs : m_BandPairs) out.insert(out.end(), pairs.begin(), pairs.end());
+    }
+
+private:
+    inline std::uint32_t getCell(float x, float y) const noexcept
+    {
+        const auto cx(std::min(static_cast<unsigned int>(std::max(x * m_InvCellSize, 0.f)), m_Cols - 1));
+        const auto cy(std::min(static_cast<unsigned int>(std::max(y * m_InvCellSize, 0.f)), m_Rows - 1));
+        return cy * m_Cols + cx;
+    }
+
+    inline void findPairsInCell(const BodyStore& bodies, unsigned int col, unsigned int row, std::vector<BodyPair>& pairs) const
+    {
+        const auto cell(row * m_Cols + col);
+        const auto begin(m_CellStart[cell]), end(m_CellStart[cell + 1]);
+        if (begin == end) return;
+
+        // Within the cell
+        for (auto i(begin); i < end; ++i)
+            for (auto j(i + 1); j < end; ++j) addPairIfOverlapping(bodies, m_Sorted[i], m_Sorted[j], pairs);
+
+        // Against the forward half of the neighbourhood
+        static const int offsets[][2] = {{1, 0}, {-1, 1}, {0, 1}, {1, 1}};
+        for (const auto& o : offsets)
+        {
+            const auto nc(static_cast<int>(col) + o[0]), nr(static_cast<int>(row) + o[1]);
+            if (nc < 0 || nc >= static_cast<int>(m_Cols) || nr >= static_cast<int>(m_Rows)) continue;
+
+            const auto other(static_cast<unsigned int>(nr) * m_Cols + static_cast<unsigned int>(nc));
+            for (auto i(begin); i < end; ++i)
+                for (auto j(m_CellStart[other]); j < m_CellStart[other + 1]; ++j) addPairIfOverlapping(bodies, m_Sorted[i], m_Sorted[j], pairs);
+        }
+    }
+
+    float m_CellSize{1.f}, m_InvCellSize{1.f};
+    unsigned int m_Cols{1}, m_Rows{1};
+    std::vector<std::uint32_t> m_CellStart, m_Fill, m_CellOf, m_Sorted;
+    std::vector<std::vector<BodyPair>> m_BandPairs;
+};
+
+// Incremental sort and sweep along the x axis. The bodies stay sorted by their left edge from one tick to the
+// next, so the insertion sort that restores the order only has to move the few bodies that passed each other.
+// The sweep then only tests bodies whose x intervals overlap. Best for sparse scenes and for bodies of very
+// different sizes; degrades when many bodies share the same x range.
+class SweepAndPrune : public Broadphase
+{
+public:
+    static constexpr std::size_t entriesPerJob{4096};
+
+    inline const char* getName() const noexcept override { return "sap"; }
+
+    inline std::size_t getMemoryUsage() const noexcept override
+    {
+        auto bytes(m_Entries.capacity() * sizeof(Entry));
+        for (const auto& pairs : m_ChunkPairs) bytes += pairs.capacity() * sizeof(BodyPair);
+        return bytes;
+    }
+
+    inline void findPairs(const BodyStore& bodies, std::vector<BodyPair>& out, JobSystem* jobs) override
+    {
+        updateOrder(bodies);
+
+        // Chunks of the sorted order are swept in parallel; every chunk may look past its end
+        const auto chunkCount((m_Entries.size() + entriesPerJob - 1) / entriesPerJob);
+        m_ChunkPairs.resize(chunkCount);
+
+        const auto sweep([this, &bodies](std::size_t first, std::size_t last)
+        {
+            auto& pairs(m_ChunkPairs[first / entriesPerJob]);
+            pairs.clear();
+            for (auto i(first); i < last; ++i)
+            {
+                const auto& e(m_Entries[i]);
+                for (auto j(i + 1); j < m_Entries.size() && m_Entries[j].min <= e.max; ++j)
+                    addPairIfOverlapping(bodies, e.body, m_Entries[j].body, pairs);
+            }
+        });
+
+        if (jobs != nullptr) jobs->parallelFor(0, m_Entries.size(), entriesPerJob, sweep);
+        else
+            for (std::size_t first(0); first < m_Entries.size(); first += entriesPerJob)
+                sweep(first, std::min(first + entriesPerJob, m_Entries.size()));
+
+        out.clear();
+        for (const auto& pairs : m_ChunkPairs) out.insert(out.end(), pairs.begin(), pairs.end());
+    }
+
+    // Number of entries moved by the last insertion sort, a measure of how coherent the scene is
+    inline std::size_t getLastSwapCount() const noexcept { return m_LastSwaps; }
+
+private:
+    struct Entry
+    {
+        float min, max;
+        std::uint32_t body;
+    };
+
+    inline void updateOrder(const BodyStore& bodies)
+    {
+        const auto count(bodies.size());
+        if (m_Entries.size() != count)
+        {
+            // Body set changed: start over from a full sort
+            m_Entries.resize(count);
+            for (std::uint32_t i(0); i < count; ++i) m_Entries[i].body = i;
+            refreshBounds(bodies);
+            std::sort(m_Entries.begin(), m_Entries.end(), isBefore);
+            m_LastSwaps = count;
+            return;
+        }
+
+        refreshBounds(bodies);
+
+        m_LastSwaps = 0;
+        for (std::size_t i(1); i < count; ++i)
+        {
+            const auto e(m_Entries[i]);
+            auto j(i);
+            for (; j > 0 && isBefore(e, m_Entries[j - 1]); --j) m_Entries[j] = m_Entries[j - 1];
+            if (j != i)
+            {
+                m_Entries[j] = e;
+                ++m_LastSwaps;
+            }
+        }
+    }
+
+    // Ties are broken by body index, so the order only depends on the current positions and not on the
+    // order of the previous tick (which keeps rollback and resimulation exact)
+    inline static bool isBefore(const Entry& a, const Entry& b) noexcept
+    {
+        return a.min < b.min || (a.min == b.min && a.body < b.body);
+    }
+
+    inline void refreshBounds(const BodyStore& bodies) noexcept
+    {
+        for (auto& e : m_Entries)
+        {
+            e.min = bodies.x[e.body] - bodies.radius[e.body];
+            e.max = bodies.x[e.body] + bodies.radius[e.body];
+        }
+    }
+
+    std::vector<Entry> m_Entries;
+    std::vector<std::vector<BodyPair>> m_ChunkPairs;
+    std::size_t m_LastSwaps{0};
+};
\ No newline at end of file
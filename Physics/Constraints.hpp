@@ -0,0 +1,336 @@
+#pragma once
+#include "Bodies.hpp"
+#include "StepKernel.hpp"
+
+// Keeps bodies a and b at `rest` distance; stiffness in [0, 1] is the fraction of the error corrected per iteration
+struct DistanceConstraint
+{
+    std::uint32_t a, b;
+    float rest, stiffness;
+};
+
+// Holds a body at a fixed point
+struct PinConstraint
+{
+    std::uint32_t body;
+    Vec2f anchor;
+};
+
+// Position-based solver for distance and pin constraints (ropes, cloth, soft blobs), run after the
+// integration and contact steps. Every iteration moves the bodies of each distance constraint towards its
+// rest length, weighted by inverse mass (proportional to 1 / radius^2, 0 for pinned bodies); afterwards the
+// velocities pick up the total correction divided by the time step, as in Verlet integration.
+//
+// Constraints are greedily graph-colored so that no two constraints of a color share a body. Each color is
+// one contiguous structure-of-arrays batch that is relaxed in parallel on the job system, and with AVX2
+// eight constraints at a time (gathered loads, scalar stores). Within a color the order doesn't matter, so
+// the result is the same for any thread count and for both paths. solveGaussSeidel() is the serial reference
+// that relaxes the constraints one after another in the order they were added.
+class ConstraintSolver
+{
+public:
+    static constexpr std::size_t constraintsPerJob{2048};
+
+    // Constraints that don't fit into the first 64 colors go into one extra batch that is relaxed serially
+    static constexpr std::size_t maxParallelColors{64};
+
+    inline void setIterations(std::size_t iterations) noexcept { m_Iterations = std::max<std::size_t>(iterations, 1); }
+    inline std::size_t getIterations() const noexcept { return m_Iterations; }
+
+    // Only Scalar and AVX2 have their own paths; SSE2 has no gathers and uses the scalar one
+    inline void setIsa(StepIsa isa) noexcept { m_Isa = isStepIsaSupported(isa) ? isa : StepIsa::Scalar; }
+
+    inline std::size_t addDistance(std::uint32_t a, std::uint32_t b, float rest, float stiffness = 1.f)
+    {
+        m_Distances.emplace_back(DistanceConstraint{a, b, rest, stiffness});
+        m_Dirty = true;
+        return m_Distances.size() - 1;
+    }
+
+    // Uses the current distance of the two bodies as rest length
+    inline std::size_t addDistance(const BodyStore& bodies, std::uint32_t a, std::uint32_t b, float stiffness = 1.f)
+    {
+        const auto dx(bodies.x[b] - bodies.x[a]), dy(bodies.y[b] - bodies.y[a]);
+        return addDistance(a, b, std::sqrt(dx*dx + dy*dy), stiffness);
+    }
+
+    inline void addPin(std::uint32_t body, Vec2f anchor)
+    {
+        m_Pins.emplace_back(PinConstraint{body, anchor});
+        m_Dirty = true;
+    }
+
+    inline void clear() noexcept
+    {
+        m_Distances.clear();
+        m_Pins.clear();
+        m_Dirty = true;
+    }
+
+    inline bool empty() const noexcept { return m_Distances.empty() && m_Pins.empty(); }
+    inline const std::vector<DistanceConstraint>& getDistances() const noexcept { return m_Distances; }
+    inline const std::vector<PinConstraint>& getPins() const noexcept { return m_Pins; }
+
+    // Number of batches, including the serial one if it is needed
+    inline std::size_t getColorCount() noexcept
+    {
+        if (m_Dirty) build();
+        return m_ColorStart.size() - 1;
+    }
+
+    inline void solve(BodyStore& bodies, float ft, JobSystem* jobs)
+    {
+        if (empty()) return;
+        if (m_Dirty) build();
+        beginSolve(bodies);
+
+        for (std::size_t it(0); it < m_Iterations; ++it)
+        {
+            for (std::size_t color(0); color + 1 < m_ColorStart.size(); ++color)
+            {
+                const auto first(m_ColorStart[color]), last(m_ColorStart[color + 1]);
+                const auto relax([this, &bodies, color](std::size_t from, std::size_t to) { relaxBatch(bodies, color, from, to); });
+                if (jobs != nullptr && color < maxParallelColors) jobs->parallelFor(first, last, constraintsPerJob, relax);
+                else relax(first, last);
+            }
+            applyPins(bodies);
+        }
+
+        endSolve(bodies, ft);
+    }
+
+    // Serial reference: same iterations, constraints in the order they were added
+    inline void solveGaussSeidel(BodyStore& bodies, float ft)
+    {
+        if (empty()) return;
+        if (m_Dirty) build();
+        beginSolve(bodies);
+
+        auto x(bodies.x.data()), y(bodies.y.data());
+        for (std::size_t it(0); it < m_Iterations; ++it)
+        {
+            for (const auto& c : m_Distances)
+            {
+                const auto wa(m_InvMass[c.a]), wb(m_InvMass[c.b]);
+                const auto dx(x[c.b] - x[c.a]), dy(y[c.b] - y[c.a]);
+                const auto len(std::sqrt(dx*dx + dy*dy)), w(wa + wb);
+                const auto k(len > 0.f && w > 0.f ? (len - c.rest) / (len * w) * c.stiffness : 0.f);
+
+                x[c.a] += dx*k*wa;
+                y[c.a] += dy*k*wa;
+                x[c.b] -= dx*k*wb;
+                y[c.b] -= dy*k*wb;
+            }
+            applyPins(bodies);
+        }
+
+        endSolve(bodies, ft);
+    }
+
+    // Mean of |length - rest| / rest over all distance constraints
+    inline float getError(const BodyStore& bodies) const noexcept
+    {
+        if (m_Distances.empty()) return 0.f;
+
+        auto sum(0.0);
+        for (const auto& c : m_Distances)
+        {
+            const auto dx(bodies.x[c.b] - bodies.x[c.a]), dy(bodies.y[c.b] - bodies.y[c.a]);
+            sum += std::abs(std::sqrt(dx*dx + dy*dy) - c.rest) / std::max(c.rest, 1e-6f);
+        }
+        return static_cast<float>(sum / m_Distances.size());
+    }
+
+    inline std::size_t getMemoryUsage() const noexcept
+    {
+        return m_Distances.capacity() * sizeof(DistanceConstraint) + m_Pins.capacity() * sizeof(PinConstraint)
+            + (m_A.capacity() + m_B.capacity() + m_ColorStart.capacity() + m_Constrained.capacity()) * sizeof(std::uint32_t)
+            + (m_Rest.capacity() + m_Stiffness.capacity() + m_InvMass.capacity() + m_StartX.capacity() + m_StartY.capacity()) * sizeof(float);
+    }
+
+private:
+    // Greedy coloring in insertion order, then a counting sort of the constraints into per-color batches
+    inline void build()
+    {
+        std::uint32_t bodyCount{0};
+        for (const auto& c : m_Distances) bodyCount = std::max(bodyCount, std::max(c.a, c.b) + 1);
+        for (const auto& p : m_Pins) bodyCount = std::max(bodyCount, p.body + 1);
+
+        std::vector<std::uint64_t> usedColors(bodyCount, 0);
+        std::vector<std::uint32_t> colorOf(m_Distances.size());
+        std::vector<std::uint32_t> counts(maxParallelColors + 1, 0);
+        for (std::size_t i(0); i < m_Distances.size(); ++i)
+        {
+            const auto& c(m_Distances[i]);
+            const auto used(usedColors[c.a] | usedColors[c.b]);
+            std::uint32_t color{0};
+            while (color < maxParallelColors && (used & (1ull << color)) != 0) ++color;
+            if (color < maxParallelColors)
+            {
+                usedColors[c.a] |= 1ull << color;
+                usedColors[c.b] |= 1ull << color;
+            }
+            colorOf[i] = color;
+            ++counts[color];
+        }
+
+        // Empty colors only occur at the end (plus the serial batch), drop them
+        auto colorCount(maxParallelColors);
+        while (colorCount > 0 && counts[colorCount - 1] == 0) --colorCount;
+        if (counts[maxParallelColors] > 0) counts[colorCount++] = counts[maxParallelColors];
+
+        m_ColorStart.assign(colorCount + 1, 0);
+        for (std::size_t color(0); color < colorCount; ++color) m_ColorStart[color + 1] = m_ColorStart[color] + counts[color];
+
+        const auto size(m_Distances.size());
+        m_A.resize(size);
+        m_B.resize(size);
+        m_Rest.resize(size);
+        m_Stiffness.resize(size);
+        std::vector<std::uint32_t> fill(m_ColorStart.begin(), m_ColorStart.end() - 1);
+        for (std::size_t i(0); i < size; ++i)
+        {
+            const auto color(colorOf[i] == maxParallelColors ? colorCount - 1 : colorOf[i]);
+            const auto slot(fill[color]++);
+            const auto& c(m_Distances[i]);
+            m_A[slot] = c.a;
+            m_B[slot] = c.b;
+            m_Rest[slot] = c.rest;
+            m_Stiffness[slot] = c.stiffness;
+        }
+
+        // Every body touched by a constraint, for the per-solve bookkeeping
+        std::vector<bool> constrained(bodyCount, false);
+        for (const auto& c : m_Distances) constrained[c.a] = constrained[c.b] = true;
+        for (const auto& p : m_Pins) constrained[p.body] = true;
+        m_Constrained.clear();
+        for (std::uint32_t i(0); i < bodyCount; ++i)
+            if (constrained[i]) m_Constrained.emplace_back(i);
+
+        m_InvMass.assign(bodyCount, 0.f);
+        m_StartX.resize(m_Constrained.size());
+        m_StartY.resize(m_Constrained.size());
+        m_Dirty = false;
+    }
+
+    inline void beginSolve(const BodyStore& bodies) noexcept
+    {
+        for (std::size_t i(0); i < m_Constrained.size(); ++i)
+        {
+            const auto body(m_Constrained[i]);
+            m_InvMass[body] = 1.f / (bodies.radius[body] * bodies.radius[body]);
+            m_StartX[i] = bodies.x[body];
+            m_StartY[i] = bodies.y[body];
+        }
+        for (const auto& p : m_Pins) m_InvMass[p.body] = 0.f;
+    }
+
+    // The correction becomes velocity; pinned bodies stay at rest
+    inline void endSolve(BodyStore& bodies, float ft) noexcept
+    {
+        const auto invFt(1.f / ft);
+        for (std::size_t i(0); i < m_Constrained.size(); ++i)
+        {
+            const auto body(m_Constrained[i]);
+            bodies.vx[body] += (bodies.x[body] - m_StartX[i]) * invFt;
+            bodies.vy[body] += (bodies.y[body] - m_StartY[i]) * invFt;
+        }
+        for (const auto& p : m_Pins) bodies.vx[p.body] = bodies.vy[p.body] = 0.f;
+    }
+
+    inline void applyPins(BodyStore& bodies) const noexcept
+    {
+        for (const auto& p : m_Pins)
+        {
+            bodies.x[p.body] = p.anchor.x;
+            bodies.y[p.body] = p.anchor.y;
+        }
+    }
+
+    // The serial batch past the parallel colors may touch a body several times, so its constraints have to be
+    // relaxed one after another
+    inline void relaxBatch(BodyStore& bodies, std::size_t color, std::size_t first, std::size_t last) noexcept
+    {
+#ifdef PHYSICS_STEP_X86
+        if (m_Isa == StepIsa::AVX2 && color < maxParallelColors)
+        {
+            relaxBatchAVX2(bodies, first, last);
+            return;
+        }
+#endif
+        relaxBatchScalar(bodies, first, last);
+    }
+
+    inline void relaxBatchScalar(BodyStore& bodies, std::size_t first, std::size_t last) noexcept
+    {
+        auto x(bodies.x.data()), y(bodies.y.data());
+        for (auto i(first); i < last; ++i)
+        {
+            const auto a(m_A[i]), b(m_B[i]);
+            const auto wa(m_InvMass[a]), wb(m_InvMass[b]);
+            const auto dx(x[b] - x[a]), dy(y[b] - y[a]);
+            const auto len(std::sqrt(dx*dx + dy*dy)), w(wa + wb);
+            const auto k(len > 0.f && w > 0.f ? (len - m_Rest[i]) / (len * w) * m_Stiffness[i] : 0.f);
+
+            x[a] += dx*k*wa;
+            y[a] += dy*k*wa;
+            x[b] -= dx*k*wb;
+            y[b] -= dy*k*wb;
+        }
+    }
+
+#ifdef PHYSICS_STEP_X86
+    // Same operations in the same order as the scalar path, without FMA, so the results are bit-identical
+    __attribute__((target("avx2")))
+    inline void relaxBatchAVX2(BodyStore& bodies, std::size_t first, std::size_t last) noexcept
+    {
+        auto x(bodies.x.data()), y(bodies.y.data());
+        const auto zero(_mm256_setzero_ps());
+
+        auto i(first);
+        for (; i + 8 <= last; i += 8)
+        {
+            const auto ia(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(&m_A[i])));
+            const auto ib(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(&m_B[i])));
+            const auto wa(_mm256_i32gather_ps(m_InvMass.data(), ia, 4)), wb(_mm256_i32gather_ps(m_InvMass.data(), ib, 4));
+            const auto xa(_mm256_i32gather_ps(x, ia, 4)), ya(_mm256_i32gather_ps(y, ia, 4));
+            const auto xb(_mm256_i32gather_ps(x, ib, 4)), yb(_mm256_i32gather_ps(y, ib, 4));
+
+            const auto dx(_mm256_sub_ps(xb, xa)), dy(_mm256_sub_ps(yb, ya));
+            const auto len(_mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy))));
+            const auto w(_mm256_add_ps(wa, wb));
+            const auto valid(_mm256_and_ps(_mm256_cmp_ps(len, zero, _CMP_GT_OQ), _mm256_cmp_ps(w, zero, _CMP_GT_OQ)));
+            const auto k(_mm256_and_ps(valid, _mm256_mul_ps(_mm256_div_ps(_mm256_sub_ps(len, _mm256_loadu_ps(&m_Rest[i])),
+                _mm256_mul_ps(len, w)), _mm256_loadu_ps(&m_Stiffness[i]))));
+
+            const auto dxk(_mm256_mul_ps(dx, k)), dyk(_mm256_mul_ps(dy, k));
+            alignas(32) float outXa[8], outYa[8], outXb[8], outYb[8];
+            _mm256_store_ps(outXa, _mm256_add_ps(xa, _mm256_mul_ps(dxk, wa)));
+            _mm256_store_ps(outYa, _mm256_add_ps(ya, _mm256_mul_ps(dyk, wa)));
+            _mm256_store_ps(outXb, _mm256_sub_ps(xb, _mm256_mul_ps(dxk, wb)));
+            _mm256_store_ps(outYb, _mm256_sub_ps(yb, _mm256_mul_ps(dyk, wb)));
+
+            // Only called for real colors, where no body appears twice, so the lanes can be stored in any order
+            for (auto j(0); j < 8; ++j)
+            {
+                x[m_A[i + j]] = outXa[j];
+                y[m_A[i + j]] = outYa[j];
+                x[m_B[i + j]] = outXb[j];
+                y[m_B[i + j]] = outYb[j];
+            }
+        }
+
+        relaxBatchScalar(bodies, i, last);
+    }
+#endif
+
+    std::size_t m_Iterations{8};
+    StepIsa m_Isa{getBestStepIsa() == StepIsa::AVX2 ? StepIsa::AVX2 : StepIsa::Scalar};
+    std::vector<DistanceConstraint> m_Distances;
+    std::vector<PinConstraint> m_Pins;
+    bool m_Dirty{false};
+
+    // Built from the constraints: per-color batches and the set of constrained bodies
+    std::vector<std::uint32_t> m_A, m_B, m_ColorStart{0}, m_Constrained;
+    std::vector<float> m_Rest, m_Stiffness, m_InvMass, m_StartX, m_StartY;
+};
@@ -1,93 +1,367 @@
 #include "../Common/Common.hpp"
+#include "Bodies.hpp"
+#include "World.hpp"
+#include "Snapshot.hpp"
+#include "Particles.hpp"
 #include <random>
 #include <chrono>
 
-constexpr int ballRadius{8};
+constexpr float ballRadius{8.f};
+constexpr std::size_t ballsPerJob{4096};
+constexpr std::size_t snapshotBudget{256 * 1024 * 1024}, maxSnapshots{600}, rewindTicks{120};
+constexpr std::size_t sparksPerContact{2};
+constexpr float linkSpacing{ballRadius * 2.5f};
+constexpr float obstacleTileSize{32.f}, obstacleCoverage{.06f};
 
-struct Ball
-{
-    sf::CircleShape shape;
-    Vec2f vel;
-};
-
-class PhysicsGame
+class PhysicsGame : public StaticGame<PhysicsGame>
 {
 public:
     inline explicit PhysicsGame(int shapeCount)
+        : StaticGame{"Physics"},
+          m_ShapeCount{shapeCount}
     {
-        m_Game.onLoadContent = [this, &shapeCount]()
-        {
-            loadContent(shapeCount);
-        };
+    }
+
+    // Seed of the initial placement; 0 (the default) seeds from the clock
+    inline void setSeed(std::uint32_t seed) noexcept { m_Seed = seed; }
+
+    // Stores the rewind history as deltas (smaller, but capturing and rewinding cost more)
+    inline void setSnapshotCompression(bool enabled) noexcept { m_CompressSnapshots = enabled; }
+
+    // Adds gravity, a pinned cloth, two ropes and two soft blobs to the balls
+    inline void setSoftBodies(bool enabled) noexcept { m_SoftBodies = enabled; }
+
+    // Scatters solid tiles over the world for the balls to bounce off
+    inline void setTiles(bool enabled) noexcept { m_Tiles = enabled; }
+
+    // Size of the simulated area; defaults to the window size and is scaled to fit the window when drawn
+    inline void setWorldSize(float width, float height) noexcept { m_WorldSize = {width, height}; }
+
+    inline PhysicsWorld& getWorld() noexcept { return m_World; }
+    inline ParticleSystem& getParticles() noexcept { return m_Particles; }
+
+private:
+    friend class StaticGame<PhysicsGame>;
+
+    inline void loadContent()
+    {
+        if (m_WorldSize.x <= 0.f || m_WorldSize.y <= 0.f)
+            m_WorldSize = {static_cast<float>(getWindowWidth()), static_cast<float>(getWindowHeight())};
+
+        // Cells as large as a ball's diameter, so colliding balls are always in neighbouring cells
+        m_World.setBounds(m_WorldSize.x, m_WorldSize.y, ballRadius * 2.f);
+
+        const auto seed(m_Seed != 0 ? m_Seed : static_cast<std::uint32_t>(std::chrono::system_clock::now().time_since_epoch().count()));
+        m_World.seed(seed);
+        m_World.getBodies().clear();
+        m_World.spawnUniform(m_ShapeCount, ballRadius, 450.f);
+        if (m_SoftBodies) addSoftBodies();
+        if (m_Tiles) addTiles(seed);
+
+        // Keep as many ticks for rewinding as fit into the budget
+        const auto snapshotSize(sizeof(PhysicsSnapshot::Header) + m_World.getBodies().getMemoryUsage());
+        m_Snapshots = SnapshotRing{std::min(std::max<std::size_t>(snapshotBudget / snapshotSize, 2), maxSnapshots)};
+        m_Snapshots.setDeltaCompression(m_CompressSnapshots);
+        m_Snapshots.push(m_World);
 
-        m_Game.onUpdate = [this](float ft)
+        m_Particles.seed(seed);
+        m_Sparks = m_Particles.addEmitter(makeSparks());
+        m_Fountain = m_Particles.addEmitter(makeFountain());
+    }
+
+    // Short flashes at every contact
+    inline static EmitterSettings makeSparks()
+    {
+        EmitterSettings sparks;
+        sparks.minLifetime = .1f;
+        sparks.maxLifetime = .35f;
+        sparks.minSpeed = 60.f;
+        sparks.maxSpeed = 240.f;
+        sparks.speed = {{0.f, 1.f}, {1.f, .2f}};
+        sparks.size = {{0.f, 2.5f}, {1.f, 1.f}};
+        sparks.color = {{0.f, sf::Color(255, 255, 220)}, {.4f, sf::Color(255, 170, 40, 200)}, {1.f, sf::Color(200, 40, 0, 0)}};
+        return sparks;
+    }
+
+    // Follows the mouse while the left button is held
+    inline static EmitterSettings makeFountain()
+    {
+        EmitterSettings fountain;
+        fountain.rate = 30000.f;
+        fountain.minLifetime = 1.f;
+        fountain.maxLifetime = 2.f;
+        fountain.minSpeed = 250.f;
+        fountain.maxSpeed = 550.f;
+        fountain.direction = -1.5707963f;
+        fountain.spread = .6f;
+        fountain.gravity = {0.f, 600.f};
+        fountain.size = {{0.f, 3.f}, {1.f, 1.f}};
+        fountain.color = {{0.f, sf::Color(120, 200, 255)}, {.6f, sf::Color(40, 90, 255, 160)}, {1.f, sf::Color(0, 0, 120, 0)}};
+        return fountain;
+    }
+
+    // Random blocks of one to three tiles
+    inline void addTiles(std::uint32_t seed)
+    {
+        const auto width(static_cast<unsigned int>(m_WorldSize.x / obstacleTileSize)), height(static_cast<unsigned int>(m_WorldSize.y / obstacleTileSize));
+        m_TileGrid.reset(width, height, {obstacleTileSize, obstacleTileSize});
+
+        std::mt19937 rng{seed};
+        std::uniform_int_distribution<unsigned int> distX(0, width - 1), distY(0, height - 1), distLength(1, 3);
+        std::bernoulli_distribution horizontal;
+        for (auto blocks(static_cast<std::size_t>(width * height * obstacleCoverage / 2.f)); blocks > 0; --blocks)
         {
-            update(ft);
-        };
+            const auto x(distX(rng)), y(distY(rng)), length(distLength(rng));
+            const auto isHorizontal(horizontal(rng));
+            for (auto i(0u); i < length; ++i)
+            {
+                const auto tx(isHorizontal ? x + i : x), ty(isHorizontal ? y : y + i);
+                if (tx < width && ty < height) m_TileGrid.setSolid(tx, ty, true);
+            }
+        }
+        m_World.setTileGrid(&m_TileGrid);
 
-        m_Game.onDraw = [this](sf::RenderTarget& target)
+        m_TileVertices.clear();
+        m_TileVertices.setPrimitiveType(sf::Quads);
+        const sf::Color color(90, 90, 110);
+        for (auto y(0u); y < height; ++y)
         {
-            draw(target);
-        };
+            for (auto x(0u); x < width; ++x)
+            {
+                if (!m_TileGrid.isSolid(x, y)) continue;
+                const auto left(x * obstacleTileSize), top(y * obstacleTileSize);
+                m_TileVertices.append({{left, top}, color});
+                m_TileVertices.append({{left + obstacleTileSize, top}, color});
+                m_TileVertices.append({{left + obstacleTileSize, top + obstacleTileSize}, color});
+                m_TileVertices.append({{left, top + obstacleTileSize}, color});
+            }
+        }
     }
 
-    inline void run() { m_Game.run(); }
-
-private:
-    inline void loadContent(int shapeCount)
+    inline void addSoftBodies()
     {
-        const auto windowWidth(m_Game.getWindowWidth());
-        const auto windowHeight(m_Game.getWindowHeight());
+        auto& bodies(m_World.getBodies());
+        auto& constraints(m_World.getConstraints());
+        constraints.clear();
+        m_World.setGravity({0.f, 500.f});
+
+        const auto add([&bodies](float x, float y) { return static_cast<std::uint32_t>(bodies.add(x, y, 0.f, 0.f, ballRadius)); });
+
+        // Cloth hanging from every sixth node of its top row
+        constexpr std::size_t clothCols{24}, clothRows{14};
+        const auto clothLeft((m_WorldSize.x - (clothCols - 1) * linkSpacing) * .5f), clothTop(ballRadius * 3.f);
+        for (std::size_t row(0); row < clothRows; ++row)
+            for (std::size_t col(0); col < clothCols; ++col)
+            {
+                const auto node(add(clothLeft + col * linkSpacing, clothTop + row * linkSpacing));
+                if (col > 0) constraints.addDistance(node - 1, node, linkSpacing);
+                if (row > 0) constraints.addDistance(node - clothCols, node, linkSpacing);
+                if (row == 0 && col % 6 == 0) constraints.addPin(node, {bodies.x[node], bodies.y[node]});
+            }
+
+        // Ropes near both walls
+        constexpr std::size_t ropeLinks{25};
+        for (auto ropeX : {m_WorldSize.x * .08f, m_WorldSize.x * .92f})
+        {
+            auto previous(add(ropeX, clothTop));
+            constraints.addPin(previous, {bodies.x[previous], bodies.y[previous]});
+            for (std::size_t i(1); i < ropeLinks; ++i)
+            {
+                const auto node(add(ropeX + i * linkSpacing * .5f, clothTop + i * linkSpacing * .86f));
+                constraints.addDistance(previous, node, linkSpacing);
+                previous = node;
+            }
+        }
 
-        auto seed(std::chrono::system_clock::now().time_since_epoch().count());
-        std::mt19937 el{seed};
-        std::uniform_int_distribution<int> distWidth(ballRadius, windowWidth - ballRadius), distHeight(ballRadius, windowHeight - ballRadius),
-            velDist(-450, 450);
+        // Blobs: a ring around a center body, held by edges, softer skip-one edges and soft spokes
+        constexpr std::size_t blobNodes{20};
+        for (auto blobX : {m_WorldSize.x * .3f, m_WorldSize.x * .7f})
+        {
+            const auto blobY(m_WorldSize.y * .7f), blobRadius(blobNodes * linkSpacing / 6.2831853f);
+            const auto center(add(blobX, blobY));
+            const auto ring(static_cast<std::uint32_t>(bodies.size()));
+            for (std::size_t i(0); i < blobNodes; ++i)
+            {
+                const auto angle(6.2831853f * i / blobNodes);
+                add(blobX + std::cos(angle) * blobRadius, blobY + std::sin(angle) * blobRadius);
+            }
+            for (std::uint32_t i(0); i < blobNodes; ++i)
+            {
+                const auto node(ring + i);
+                constraints.addDistance(bodies, node, ring + (i + 1) % blobNodes);
+                constraints.addDistance(bodies, node, ring + (i + 2) % blobNodes, .5f);
+                constraints.addDistance(bodies, center, node, .2f);
+            }
+        }
+    }
 
-        m_Balls.resize(shapeCount);
-        for (auto i(0); i < shapeCount; ++i)
+    inline Vec2f mapToWorld(int x, int y)
+    {
+        return getWindow().mapPixelToCoords({x, y}, sf::View{{0.f, 0.f, m_WorldSize.x, m_WorldSize.y}});
+    }
+
+    // B switches between the broadphases, R rewinds two seconds, the left mouse button sprays particles
+    inline void handleEvent(const sf::Event& event)
+    {
+        if (event.type == sf::Event::MouseButtonPressed || event.type == sf::Event::MouseButtonReleased)
         {
-            auto& b(m_Balls[i]);
-            b.shape.setFillColor(sf::Color::Black);
-            b.shape.setRadius(ballRadius);
-            b.shape.setPosition(distWidth(el), distHeight(el));
-            b.shape.setOrigin(ballRadius, ballRadius);
-            b.vel.x = velDist(el);
-            b.vel.y = velDist(el);
+            if (event.mouseButton.button != sf::Mouse::Left) return;
+            m_Particles.setEmitterPosition(m_Fountain, mapToWorld(event.mouseButton.x, event.mouseButton.y));
+            m_Particles.setEmitterEnabled(m_Fountain, event.type == sf::Event::MouseButtonPressed);
+            return;
         }
+        if (event.type == sf::Event::MouseMoved)
+        {
+            m_Particles.setEmitterPosition(m_Fountain, mapToWorld(event.mouseMove.x, event.mouseMove.y));
+            return;
+        }
+        if (event.type != sf::Event::KeyPressed) return;
 
+        if (event.key.code == sf::Keyboard::B)
+            m_World.setBroadphase(m_World.getBroadphaseType() == BroadphaseType::Grid ? BroadphaseType::SweepAndPrune : BroadphaseType::Grid);
+        else if (event.key.code == sf::Keyboard::R)
+            m_Snapshots.rewind(m_World, std::min(rewindTicks, std::max<std::size_t>(m_Snapshots.getCount(), 1) - 1));
     }
 
     inline void update(float ft)
-    {        
-        const auto windowWidth(m_Game.getWindowWidth());
-        const auto windowHeight(m_Game.getWindowHeight());
+    {
+        TRACE_SCOPE("PhysicsGame::update");
+        m_World.step(ft, getJobs());
 
-        for (auto& b : m_Balls)
         {
-            const auto& p(b.shape.getPosition());
-            if (p.x < ballRadius) b.vel.x = -b.vel.x;
-            else if (p.x > windowWidth - ballRadius) b.vel.x = -b.vel.x;
+            TRACE_SCOPE("snapshot");
+            m_Snapshots.push(m_World);
+        }
 
-            if (p.y < ballRadius) b.vel.y = -b.vel.y;
-            else if (p.y > windowHeight - ballRadius) b.vel.y = -b.vel.y;
+        TRACE_SCOPE("particles");
+        const auto& bodies(m_World.getBodies());
+        for (const auto& p : m_World.getPairs())
+            m_Particles.emit(m_Sparks, sparksPerContact, {(bodies.x[p.a] + bodies.x[p.b]) * .5f, (bodies.y[p.a] + bodies.y[p.b]) * .5f});
+        m_Particles.update(ft, getJobs());
+    }
 
-            b.shape.move(b.vel*ft);
-        }
+    // Snapshot of the body positions for drawing, so update can keep running during draw when pipelined
+    inline void publish()
+    {
+        const auto& bodies(m_World.getBodies());
+        m_Published.prevX = bodies.prevX;
+        m_Published.prevY = bodies.prevY;
+        m_Published.x = bodies.x;
+        m_Published.y = bodies.y;
+        m_Published.radius = bodies.radius;
+
+        // Only the live particles
+        const auto& particles(m_Particles.getBodies());
+        const auto count(static_cast<std::ptrdiff_t>(m_Particles.size()));
+        m_PublishedParticles.prevX.assign(particles.prevX.begin(), particles.prevX.begin() + count);
+        m_PublishedParticles.prevY.assign(particles.prevY.begin(), particles.prevY.begin() + count);
+        m_PublishedParticles.x.assign(particles.x.begin(), particles.x.begin() + count);
+        m_PublishedParticles.y.assign(particles.y.begin(), particles.y.begin() + count);
+        m_PublishedParticles.radius.assign(particles.radius.begin(), particles.radius.begin() + count);
+        m_PublishedColors.assign(m_Particles.getColors().begin(), m_Particles.getColors().begin() + count);
     }
 
-    inline void draw(sf::RenderTarget& target)
+    inline void fpsUpdated(int fps)
     {
-        for (const auto& b : m_Balls) target.draw(b.shape);
+        if (isHeadless()) return;
+
+        std::ostringstream title;
+        title << std::fixed << std::setprecision(2) << "Physics - FPS: " << fps << " - " << m_World.getBroadphase().getName() << ": "
+              << std::chrono::duration<double, std::milli>(m_World.getBroadphaseTime()).count() << " ms, " << m_World.getPairs().size() << " pairs, "
+              << m_Particles.size() << " particles";
+        getWindow().setTitle(title.str());
+    }
+
+    // All balls go into one vertex array and one draw call, and all particles into another
+    inline void draw(sf::RenderTarget& target, float alpha)
+    {
+        const auto& p(m_Published);
+        m_Batch.resize(p.size());
+        getJobs().parallelFor(0, p.size(), ballsPerJob, [this, &p, alpha](std::size_t first, std::size_t last)
+        {
+            for (auto i(first); i < last; ++i)
+                m_Batch.setCircle(i, p.prevX[i] + (p.x[i] - p.prevX[i])*alpha, p.prevY[i] + (p.y[i] - p.prevY[i])*alpha, p.radius[i]);
+        });
+
+        const auto& q(m_PublishedParticles);
+        m_ParticleBatch.resize(q.size());
+        getJobs().parallelFor(0, q.size(), ParticleSystem::particlesPerJob, [this, &q, alpha](std::size_t first, std::size_t last)
+        {
+            for (auto i(first); i < last; ++i)
+            {
+                m_ParticleBatch.setCircle(i, q.prevX[i] + (q.x[i] - q.prevX[i])*alpha, q.prevY[i] + (q.y[i] - q.prevY[i])*alpha,
+                    q.radius[i], m_PublishedColors[i]);
+            }
+        });
+
+        target.setView(sf::View{{0.f, 0.f, m_WorldSize.x, m_WorldSize.y}});
+        target.draw(m_TileVertices);
+        target.draw(m_Batch);
+        target.draw(m_ParticleBatch, sf::BlendAdd);
     }
 
 private:
-    Game m_Game{"Physics"};
-    std::vector<Ball> m_Balls;
+    int m_ShapeCount;
+    std::uint32_t m_Seed{0};
+    bool m_CompressSnapshots{false}, m_SoftBodies{false}, m_Tiles{false};
+    SnapshotRing m_Snapshots{1};
+    Vec2f m_WorldSize;
+    PhysicsWorld m_World;
+    TileGrid m_TileGrid;
+    sf::VertexArray m_TileVertices;
+    BodyStore m_Published;
+    CircleBatch m_Batch;
+    ParticleSystem m_Particles;
+    std::size_t m_Sparks{0}, m_Fountain{0};
+    BodyStore m_PublishedParticles;
+    std::vector<sf::Color> m_PublishedColors;
+    CircleBatch m_ParticleBatch{16};
 };
 
-int main()
+// Usage: Physics [--balls N] [--world WIDTH HEIGHT] [--isa scalar|sse2|avx2] [--broadphase grid|sap] [--seed N] [--compress-snapshots] [--particles CAPACITY] [--soft] [--tiles] plus the GameBase flags (see GameBase::runFromArgs)
+int main(int argc, char* argv[])
 {
-    PhysicsGame{15}.run();
-    return 0;
-}
\ No newline at end of file
+    auto ballCount(2000);
+    auto worldWidth(0.f), worldHeight(0.f);
+    auto isa(getBestStepIsa());
+    auto broadphase(BroadphaseType::Grid);
+    std::uint32_t seed{0};
+    auto compressSnapshots(false), softBodies(false), tiles(false);
+    std::size_t particleCapacity{65536};
+    for (auto i(1); i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--compress-snapshots") == 0) compressSnapshots = true;
+        else if (std::strcmp(argv[i], "--soft") == 0) softBodies = true;
+        else if (std::strcmp(argv[i], "--tiles") == 0) tiles = true;
+        if (i + 1 >= argc) break;
+
+        if (std::strcmp(argv[i], "--balls") == 0) ballCount = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--particles") == 0) particleCapacity = std::strtoul(argv[i + 1], nullptr, 10);
+        else if (std::strcmp(argv[i], "--world") == 0 && i + 2 < argc)
+        {
+            worldWidth = std::strtof(argv[i + 1], nullptr);
+            worldHeight = std::strtof(argv[i + 2], nullptr);
+        }
+        else if (std::strcmp(argv[i], "--seed") == 0) seed = static_cast<std::uint32_t>(std::strtoul(argv[i + 1], nullptr, 10));
+        else if (std::strcmp(argv[i], "--broadphase") == 0)
+        {
+            broadphase = std::strcmp(argv[i + 1], "sap") == 0 ? BroadphaseType::SweepAndPrune : BroadphaseType::Grid;
+        }
+        else if (std::strcmp(argv[i], "--isa") == 0)
+        {
+            for (auto candidate : {StepIsa::Scalar, StepIsa::SSE2, StepIsa::AVX2})
+                if (std::strcmp(argv[i + 1], getStepIsaName(candidate)) == 0) isa = candidate;
+        }
+    }
+
+    PhysicsGame game{ballCount};
+    game.getWorld().setStepIsa(isa);
+    game.getWorld().setBroadphase(broadphase);
+    game.setSeed(seed);
+    game.setSnapshotCompression(compressSnapshots);
+    game.setSoftBodies(softBodies);
+    game.setTiles(tiles);
+    game.getParticles().setCapacity(particleCapacity);
+    game.setWorldSize(worldWidth, worldHeight);
+    return game.run(argc, argv);
+}
@@ -0,0 +1,220 @@
+#pragma once
+#include "Bodies.hpp"
+#include <random>
+
+inline float interpolate(float a, float b, float t) noexcept { return a + (b - a) * t; }
+
+inline sf::Color interpolate(sf::Color a, sf::Color b, float t) noexcept
+{
+    const auto channel([t](sf::Uint8 from, sf::Uint8 to)
+    {
+        return static_cast<sf::Uint8>(from + (static_cast<float>(to) - from) * t + .5f);
+    });
+    return {channel(a.r, b.r), channel(a.g, b.g), channel(a.b, b.b), channel(a.a, b.a)};
+}
+
+// Piecewise linear curve over a particle's normalized age: 0 at spawn, 1 at death.
+// Keys have to be sorted by time; before the first and after the last key the curve is constant.
+template <typename T>
+class Curve
+{
+public:
+    inline Curve(T value = T{}) : m_Keys{{0.f, value}} { }
+    inline Curve(std::initializer_list<std::pair<float, T>> keys) : m_Keys(keys) { assert(!m_Keys.empty()); }
+
+    inline T sample(float t) const noexcept
+    {
+        if (t <= m_Keys.front().first) return m_Keys.front().second;
+        for (std::size_t i(1); i < m_Keys.size(); ++i)
+        {
+            if (t >= m_Keys[i].first) continue;
+            const auto& a(m_Keys[i - 1]);
+            const auto& b(m_Keys[i]);
+            return interpolate(a.second, b.second, (t - a.first) / (b.first - a.first));
+        }
+        return m_Keys.back().second;
+    }
+
+private:
+    std::vector<std::pair<float, T>> m_Keys;
+};
+
+struct EmitterSettings
+{
+    float rate{0.f};                                // Particles per second while the emitter is enabled
+    float minLifetime{.5f}, maxLifetime{1.f};       // Seconds
+    float minSpeed{50.f}, maxSpeed{150.f};
+    float direction{0.f}, spread{6.2831853f};       // Radians; launch angles are spread evenly around direction
+    Vec2f gravity;
+    Curve<float> speed{1.f};                        // Factor of the velocity over the lifetime
+    Curve<float> size{2.f};                         // Radius over the lifetime
+    Curve<sf::Color> color{sf::Color::White};
+};
+
+// Short-lived particles in a fixed-capacity pool. The pool is a BodyStore plus a few particle-only arrays,
+// allocated once: spawning writes the next free slot and dead particles are swap-removed with the last live
+// one, so the live particles always occupy [0, size()) and nothing is allocated per particle. Spawns beyond
+// the capacity are dropped (and counted).
+//
+// Particles don't collide. Each emitter has its own lifetime, velocity, size and color curves; the update
+// evaluates them in parallel and writes the current radius and color next to the positions, ready to be
+// drawn as one batch.
+class ParticleSystem
+{
+public:
+    static constexpr std::size_t particlesPerJob{8192};
+
+    inline explicit ParticleSystem(std::size_t capacity = 65536) { setCapacity(capacity); }
+
+    // Kills every particle
+    inline void setCapacity(std::size_t capacity)
+    {
+        m_Bodies.resize(capacity);
+        m_Age.resize(capacity);
+        m_Lifetime.resize(capacity);
+        m_Emitter.resize(capacity);
+        m_Colors.resize(capacity);
+        m_Count = 0;
+    }
+
+    inline std::size_t getCapacity() const noexcept { return m_Age.size(); }
+    inline std::size_t size() const noexcept { return m_Count; }
+
+    inline void seed(std::uint32_t value) { m_Rng.seed(value); }
+
+    // Returns the emitter's id
+    inline std::size_t addEmitter(const EmitterSettings& settings)
+    {
+        m_Emitters.emplace_back(settings);
+        return m_Emitters.size() - 1;
+    }
+
+    inline EmitterSettings& getEmitter(std::size_t id) noexcept { return m_Emitters[id].settings; }
+    inline void setEmitterPosition(std::size_t id, Vec2f position) noexcept { m_Emitters[id].position = position; }
+    inline void setEmitterEnabled(std::size_t id, bool enabled) noexcept { m_Emitters[id].enabled = enabled; }
+
+    // Spawns `count` particles of emitter `id` at `position` at once
+    inline void emit(std::size_t id, std::size_t count, Vec2f position)
+    {
+        const auto& e(m_Emitters[id].settings);
+        std::uniform_real_distribution<float> distLifetime(e.minLifetime, e.maxLifetime), distSpeed(e.minSpeed, e.maxSpeed),
+            distAngle(e.direction - e.spread * .5f, e.direction + e.spread * .5f);
+        const auto radius(e.size.sample(0.f));
+        const auto color(e.color.sample(0.f));
+
+        const auto spawned(std::min(count, getCapacity() - m_Count));
+        for (std::size_t n(0); n < spawned; ++n)
+        {
+            const auto i(m_Count++);
+            const auto angle(distAngle(m_Rng)), speed(distSpeed(m_Rng));
+            m_Bodies.x[i] = m_Bodies.prevX[i] = position.x;
+            m_Bodies.y[i] = m_Bodies.prevY[i] = position.y;
+            m_Bodies.vx[i] = std::cos(angle) * speed;
+            m_Bodies.vy[i] = std::sin(angle) * speed;
+            m_Bodies.radius[i] = radius;
+            m_Age[i] = 0.f;
+            m_Lifetime[i] = distLifetime(m_Rng);
+            m_Emitter[i] = static_cast<std::uint32_t>(id);
+            m_Colors[i] = color;
+        }
+
+        m_Spawned += spawned;
+        m_Dropped += count - spawned;
+    }
+
+    // Ages and moves every particle, removes the dead ones, then lets the enabled emitters spawn
+    inline void update(float ft, JobSystem& jobs)
+    {
+        jobs.parallelFor(0, m_Count, particlesPerJob, [this, ft](std::size_t first, std::size_t last)
+        {
+            auto& b(m_Bodies);
+            for (auto i(first); i < last; ++i)
+            {
+                m_Age[i] += ft;
+                if (m_Age[i] >= m_Lifetime[i]) continue;
+
+                const auto& e(m_Emitters[m_Emitter[i]].settings);
+                const auto t(m_Age[i] / m_Lifetime[i]);
+                const auto speed(e.speed.sample(t));
+                b.vx[i] += e.gravity.x * ft;
+                b.vy[i] += e.gravity.y * ft;
+                b.prevX[i] = b.x[i];
+                b.prevY[i] = b.y[i];
+                b.x[i] += b.vx[i] * speed * ft;
+                b.y[i] += b.vy[i] * speed * ft;
+                b.radius[i] = e.size.sample(t);
+                m_Colors[i] = e.color.sample(t);
+            }
+        });
+
+        // Swap-remove: the last live particle takes the dead one's slot, so the order changes but stays dense
+        const auto before(m_Count);
+        for (std::size_t i(0); i < m_Count;)
+        {
+            if (m_Age[i] < m_Lifetime[i])
+            {
+                ++i;
+                continue;
+            }
+
+            const auto last(--m_Count);
+            if (i == last) break;
+            m_Bodies.copy(last, i);
+            m_Age[i] = m_Age[last];
+            m_Lifetime[i] = m_Lifetime[last];
+            m_Emitter[i] = m_Emitter[last];
+            m_Colors[i] = m_Colors[last];
+        }
+        m_Killed += before - m_Count;
+
+        for (std::size_t id(0); id < m_Emitters.size(); ++id)
+        {
+            auto& emitter(m_Emitters[id]);
+            if (!emitter.enabled) continue;
+
+            // Fractional particles carry over to the next update
+            emitter.pending += emitter.settings.rate * ft;
+            const auto count(static_cast<std::size_t>(emitter.pending));
+            emitter.pending -= static_cast<float>(count);
+            emit(id, count, emitter.position);
+        }
+    }
+
+    // Kills every particle, keeping the emitters
+    inline void clear() noexcept { m_Count = 0; }
+
+    // Live particles are the first size() entries; the radius is the current size
+    inline const BodyStore& getBodies() const noexcept { return m_Bodies; }
+    inline const std::vector<sf::Color>& getColors() const noexcept { return m_Colors; }
+
+    // Totals since construction
+    inline std::size_t getSpawnedCount() const noexcept { return m_Spawned; }
+    inline std::size_t getKilledCount() const noexcept { return m_Killed; }
+    inline std::size_t getDroppedCount() const noexcept { return m_Dropped; }
+
+    inline std::size_t getMemoryUsage() const noexcept
+    {
+        return m_Bodies.getMemoryUsage() + (m_Age.capacity() + m_Lifetime.capacity()) * sizeof(float)
+            + m_Emitter.capacity() * sizeof(std::uint32_t) + m_Colors.capacity() * sizeof(sf::Color);
+    }
+
+private:
+    struct Emitter
+    {
+        inline explicit Emitter(const EmitterSettings& emitterSettings) : settings{emitterSettings} { }
+
+        EmitterSettings settings;
+        Vec2f position;
+        bool enabled{false};
+        float pending{0.f};
+    };
+
+    BodyStore m_Bodies;
+    std::vector<float> m_Age, m_Lifetime;
+    std::vector<std::uint32_t> m_Emitter;
+    std::vector<sf::Color> m_Colors;
+    std::size_t m_Count{0};
+    std::vector<Emitter> m_Emitters;
+    std::mt19937 m_Rng;
+    std::size_t m_Spawned{0}, m_Killed{0}, m_Dropped{0};
+};
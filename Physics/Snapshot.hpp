@@ -0,0 +1,255 @@
+#pragma once
+#include "World.hpp"
+#include <type_traits>
+
+// Complete simulation state of a PhysicsWorld (tick, RNG and every body array) in one flat byte buffer:
+// a trivially copyable header followed by the body arrays back to back. Capturing and restoring are a
+// handful of memcpys. Everything else the world holds is rebuilt from the bodies each step, so restoring a
+// snapshot and stepping again reproduces the original run exactly.
+class PhysicsSnapshot
+{
+public:
+    struct Header
+    {
+        std::uint64_t tick;
+        std::uint64_t bodyCount;
+        std::mt19937 rng;
+    };
+
+    static_assert(std::is_trivially_copyable<Header>::value, "Snapshot header has to be memcpy-able");
+
+    inline void capture(const PhysicsWorld& world)
+    {
+        const auto& b(world.m_Bodies);
+        const auto count(b.size());
+        m_Data.resize(sizeof(Header) + count * sizeof(float) * arrayCount);
+
+        const Header header{world.m_Tick, count, world.m_Rng};
+        std::memcpy(m_Data.data(), &header, sizeof(Header));
+
+        auto out(m_Data.data() + sizeof(Header));
+        for (auto v : {&b.x, &b.y, &b.vx, &b.vy, &b.radius, &b.prevX, &b.prevY})
+        {
+            std::memcpy(out, v->data(), count * sizeof(float));
+            out += count * sizeof(float);
+        }
+    }
+
+    // Returns false if the snapshot is empty
+    inline bool restore(PhysicsWorld& world) const
+    {
+        if (m_Data.size() < sizeof(Header)) return false;
+
+        Header header;
+        std::memcpy(&header, m_Data.data(), sizeof(Header));
+        world.m_Tick = header.tick;
+        world.m_Rng = header.rng;
+
+        auto& b(world.m_Bodies);
+        const auto count(static_cast<std::size_t>(header.bodyCount));
+        auto in(m_Data.data() + sizeof(Header));
+        for (auto v : {&b.x, &b.y, &b.vx, &b.vy, &b.radius, &b.prevX, &b.prevY})
+        {
+            v->resize(count);
+            std::memcpy(v->data(), in, count * sizeof(float));
+            in += count * sizeof(float);
+        }
+        return true;
+    }
+
+    inline std::uint64_t getTick() const noexcept
+    {
+        if (m_Data.size() < sizeof(Header)) return 0;
+        // The tick is the header's first member
+        std::uint64_t tick;
+        std::memcpy(&tick, m_Data.data(), sizeof(tick));
+        return tick;
+    }
+
+    inline std::vector<unsigned char>& getData() noexcept { return m_Data; }
+    inline const std::vector<unsigned char>& getData() const noexcept { return m_Data; }
+
+private:
+    static constexpr std::size_t arrayCount{7};
+
+    std::vector<unsigned char> m_Data;
+};
+
+// Delta encoding between two snapshots of the same size: the XOR of both buffers, with runs of zero bytes
+// (everything that didn't change, including the high bytes of floats that barely moved) run-length encoded.
+// The format is a sequence of [zero run][literal count][literal bytes], both counts as LEB128 varints.
+namespace SnapshotDelta
+{
+    inline unsigned char* writeVarint(unsigned char* out, std::size_t value) noexcept
+    {
+        while (value >= 0x80)
+        {
+            *out++ = static_cast<unsigned char>(value | 0x80);
+            value >>= 7;
+        }
+        *out++ = static_cast<unsigned char>(value);
+        return out;
+    }
+
+    inline std::size_t readVarint(const unsigned char*& in) noexcept
+    {
+        std::size_t value{0};
+        for (unsigned int shift(0);; shift += 7)
+        {
+            const auto byte(*in++);
+            value |= static_cast<std::size_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) return value;
+        }
+    }
+
+    inline void encode(const std::vector<unsigned char>& base, const std::vector<unsigned char>& current, std::vector<unsigned char>& out)
+    {
+        assert(base.size() == current.size());
+
+        // Worst case is alternating single equal and differing bytes: two one-byte counts per literal
+        const auto size(current.size());
+        out.resize(size * 2 + 32);
+        auto dst(out.data());
+
+        std::size_t i{0};
+        while (i < size)
+        {
+            const auto zeroStart(i);
+            while (i < size && base[i] == current[i]) ++i;
+            const auto literalStart(i);
+            while (i < size && base[i] != current[i]) ++i;
+
+            dst = writeVarint(dst, literalStart - zeroStart);
+            dst = writeVarint(dst, i - literalStart);
+            for (auto j(literalStart); j < i; ++j) *dst++ = static_cast<unsigned char>(base[j] ^ current[j]);
+        }
+        out.resize(static_cast<std::size_t>(dst - out.data()));
+    }
+
+    // Applies `delta` to `data` in place, turning the base snapshot into the encoded one
+    inline void apply(std::vector<unsigned char>& data, const std::vector<unsigned char>& delta) noexcept
+    {
+        auto in(delta.data());
+        const auto end(delta.data() + delta.size());
+        std::size_t pos{0};
+        while (in < end)
+        {
+            pos += readVarint(in);
+            const auto literals(readVarint(in));
+            for (std::size_t j(0); j < literals; ++j) data[pos++] ^= *in++;
+        }
+    }
+}
+
+// The last N snapshots of a world, for rollback. Buffers are reused once the ring is full, so pushing
+// doesn't allocate in the steady state. With delta compression only every keyframeInterval-th snapshot
+// (and the oldest one in the ring) is stored in full, the others as deltas against their predecessor.
+class SnapshotRing
+{
+public:
+    inline explicit SnapshotRing(std::size_t capacity) : m_Entries(std::max<std::size_t>(capacity, 1)) { }
+
+    inline void setDeltaCompression(bool enabled, std::size_t keyframeInterval = 30)
+    {
+        m_Compress = enabled;
+        m_KeyframeInterval = std::max<std::size_t>(keyframeInterval, 1);
+        clear();
+    }
+
+    inline std::size_t getCapacity() const noexcept { return m_Entries.size(); }
+    inline std::size_t getCount() const noexcept { return m_Count; }
+
+    inline void clear() noexcept
+    {
+        m_Count = 0;
+        m_SinceKeyframe = 0;
+    }
+
+    inline void push(const PhysicsWorld& world)
+    {
+        m_Current.capture(world);
+
+        // Dropping the oldest entry: its successor becomes the new oldest and has to be a keyframe
+        if (m_Count == m_Entries.size())
+        {
+            auto& oldest(m_Entries[m_Head]);
+            auto& next(m_Entries[(m_Head + 1) % m_Entries.size()]);
+            if (m_Count > 1 && !next.keyframe)
+            {
+                SnapshotDelta::apply(oldest.data, next.data);
+                std::swap(oldest.data, next.data);
+                next.keyframe = true;
+            }
+            m_Head = (m_Head + 1) % m_Entries.size();
+            --m_Count;
+        }
+
+        auto& entry(m_Entries[(m_Head + m_Count) % m_Entries.size()]);
+        const auto& data(m_Current.getData());
+        const auto keyframe(!m_Compress || m_Count == 0 || m_SinceKeyframe + 1 >= m_KeyframeInterval || m_Previous.getData().size() != data.size());
+
+        if (keyframe)
+        {
+            // Without compression nothing else needs the capture, so the buffers are just traded
+            if (m_Compress) entry.data = data;
+            else std::swap(entry.data, m_Current.getData());
+            m_SinceKeyframe = 0;
+        }
+        else
+        {
+            SnapshotDelta::encode(m_Previous.getData(), data, entry.data);
+            ++m_SinceKeyframe;
+        }
+        entry.keyframe = keyframe;
+        entry.tick = world.getTick();
+        ++m_Count;
+
+        if (m_Compress) std::swap(m_Previous, m_Current);
+    }
+
+    // Restores the state from `ticksBack` pushes ago (0 = the latest) and forgets every newer snapshot,
+    // so the simulation can continue from there. Returns false if the ring doesn't reach back that far.
+    inline bool rewind(PhysicsWorld& world, std::size_t ticksBack)
+    {
+        if (ticksBack >= m_Count) return false;
+        const auto target(m_Count - 1 - ticksBack);
+
+        // Walk forward from the closest keyframe
+        auto key(target);
+        while (!m_Entries[(m_Head + key) % m_Entries.size()].keyframe) --key;
+
+        auto& state(m_Current.getData());
+        state = m_Entries[(m_Head + key) % m_Entries.size()].data;
+        for (auto i(key + 1); i <= target; ++i) SnapshotDelta::apply(state, m_Entries[(m_Head + i) % m_Entries.size()].data);
+
+        m_Current.restore(world);
+        m_Count = target + 1;
+        m_SinceKeyframe = target - key;
+        if (m_Compress) m_Previous = m_Current;
+        return true;
+    }
+
+    inline std::uint64_t getOldestTick() const noexcept { return m_Count > 0 ? m_Entries[m_Head].tick : 0; }
+
+    // Bytes held by all stored snapshots (full or delta)
+    inline std::size_t getStoredBytes() const noexcept
+    {
+        std::size_t bytes{0};
+        for (std::size_t i(0); i < m_Count; ++i) bytes += m_Entries[(m_Head + i) % m_Entries.size()].data.size();
+        return bytes;
+    }
+
+private:
+    struct Entry
+    {
+        std::vector<unsigned char> data;
+        bool keyframe{true};
+        std::uint64_t tick{0};
+    };
+
+    std::vector<Entry> m_Entries;
+    std::size_t m_Head{0}, m_Count{0};
+    bool m_Compress{false};
+    std::size_t m_KeyframeInterval{30}, m_SinceKeyframe{0};
+    PhysicsSnapshot m_Current, m_Previous;
+};
\ No newline at end of file
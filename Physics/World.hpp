@@ -0,0 +1,306 @@
+#pragma once
+#include "Bodies.hpp"
+#include "StepKernel.hpp"
+#include "Broadphase.hpp"
+#include "Constraints.hpp"
+#include <random>
+
+// The complete physics step: integration with wall bounces, collision with the solid tiles of a TileGrid (if one
+// is set), broadphase, contact resolution and (if there are any) distance and pin constraints.
+//
+// Every stage runs on the job system and is deterministic: the results are bit-identical for any number of threads
+// (for a given broadphase). Bodies are split into chunks of a fixed size (not a fixed count), the pair list is
+// assembled in cell order, and contacts are solved Jacobi-style: every pair is evaluated against the state before
+// the solve, then each body gathers the results of its own contacts in pair-list order and applies their average.
+// No thread ever writes another thread's body, and every floating-point sum happens in the same order.
+enum class BroadphaseType
+{
+    Grid,
+    SweepAndPrune
+};
+
+class PhysicsWorld
+{
+public:
+    static constexpr std::size_t bodiesPerJob{4096}, pairsPerJob{8192};
+
+    // The cell size has to be at least the diameter of the largest body
+    inline void setBounds(float width, float height, float cellSize)
+    {
+        m_Size = {width, height};
+        m_CellSize = cellSize;
+        setBroadphase(m_BroadphaseType);
+    }
+
+    inline const Vec2f& getSize() const noexcept { return m_Size; }
+
+    // Can be switched between ticks
+    inline void setBroadphase(BroadphaseType type)
+    {
+        m_BroadphaseType = type;
+        if (type == BroadphaseType::SweepAndPrune) m_Broadphase = mkUPtr<SweepAndPrune>();
+        else m_Broadphase = mkUPtr<UniformGrid>(m_Size.x, m_Size.y, m_CellSize);
+        m_BroadphaseTime = HRClock::duration::zero();
+    }
+
+    inline BroadphaseType getBroadphaseType() const noexcept { return m_BroadphaseType; }
+    inline const Broadphase& getBroadphase() const noexcept { return *m_Broadphase; }
+
+    // Time the last pair generation took, and an exponential moving average of it
+    inline HRClock::duration getLastBroadphaseTime() const noexcept { return m_LastBroadphaseTime; }
+    inline HRClock::duration getBroadphaseTime() const noexcept { return m_BroadphaseTime; }
+
+    // Falls back to the best supported path if `isa` isn't available on this CPU
+    inline void setStepIsa(StepIsa isa) noexcept
+    {
+        m_Isa = isStepIsaSupported(isa) ? isa : getBestStepIsa();
+        m_Constraints.setIsa(m_Isa);
+    }
+    inline StepIsa getStepIsa() const noexcept { return m_Isa; }
+
+    inline void setRestitution(float restitution) noexcept { m_Restitution = restitution; }
+
+    // Added to every body's velocity before integrating; none by default
+    inline void setGravity(Vec2f gravity) noexcept { m_Gravity = gravity; }
+    inline const Vec2f& getGravity() const noexcept { return m_Gravity; }
+
+    inline ConstraintSolver& getConstraints() noexcept { return m_Constraints; }
+
+    // Solid tiles the bodies bounce off, in world coordinates; not owned, and not part of snapshots
+    inline void setTileGrid(const TileGrid* tiles) noexcept { m_Tiles = tiles; }
+    inline const TileGrid* getTileGrid() const noexcept { return m_Tiles; }
+
+    // Random source of the spawn functions; part of the state captured by snapshots
+    inline void seed(std::uint32_t value) { m_Rng.seed(value); }
+    inline std::mt19937& getRng() noexcept { return m_Rng; }
+
+    // Number of steps taken so far
+    inline std::uint64_t getTick() const noexcept { return m_Tick; }
+
+    inline BodyStore& getBodies() noexcept { return m_Bodies; }
+    inline const BodyStore& getBodies() const noexcept { return m_Bodies; }
+    inline const std::vector<BodyPair>& getPairs() const noexcept { return m_Pairs; }
+
+    // Adds `count` bodies spread uniformly over the world, with velocities in [-maxSpeed, maxSpeed]
+    inline void spawnUniform(std::size_t count, float radius, float maxSpeed)
+    {
+        std::uniform_real_distribution<float> distX(radius, m_Size.x - radius), distY(radius, m_Size.y - radius),
+            distVel(-maxSpeed, maxSpeed);
+
+        m_Bodies.reserve(m_Bodies.size() + count);
+        for (std::size_t i(0); i < count; ++i)
+        {
+            const auto x(distX(m_Rng)), y(distY(m_Rng));
+            const auto vx(distVel(m_Rng)), vy(distVel(m_Rng));
+            m_Bodies.add(x, y, vx, vy, radius);
+        }
+    }
+
+    // Adds `count` bodies around `clusterCount` random centers, normally distributed with a standard deviation
+    // of `spread` times the world's smaller side
+    inline void spawnClustered(std::size_t count, std::size_t clusterCount, float spread, float radius, float maxSpeed)
+    {
+        std::uniform_real_distribution<float> distX(radius, m_Size.x - radius), distY(radius, m_Size.y - radius),
+            distVel(-maxSpeed, maxSpeed);
+        std::normal_distribution<float> distOffset(0.f, spread * std::min(m_Size.x, m_Size.y));
+
+        std::vector<Vec2f> centers(std::max<std::size_t>(clusterCount, 1));
+        for (auto& c : centers)
+        {
+            c.x = distX(m_Rng);
+            c.y = distY(m_Rng);
+        }
+
+        m_Bodies.reserve(m_Bodies.size() + count);
+        for (std::size_t i(0); i < count; ++i)
+        {
+            const auto& c(centers[i % centers.size()]);
+            const auto x(std::min(std::max(c.x + distOffset(m_Rng), radius), m_Size.x - radius));
+            const auto y(std::min(std::max(c.y + distOffset(m_Rng), radius), m_Size.y - radius));
+            const auto vx(distVel(m_Rng)), vy(distVel(m_Rng));
+            m_Bodies.add(x, y, vx, vy, radius);
+        }
+    }
+
+    // Bytes held by the bodies and every per-tick structure
+    inline std::size_t getMemoryUsage() const noexcept
+    {
+        return m_Bodies.getMemoryUsage() + m_Broadphase->getMemoryUsage()
+            + m_Pairs.capacity() * sizeof(BodyPair) + m_PairResults.capacity() * sizeof(PairResult)
+            + (m_ContactStart.capacity() + m_ContactFill.capacity() + m_Contacts.capacity()) * sizeof(std::uint32_t)
+            + m_Constraints.getMemoryUsage();
+    }
+
+    inline void step(float ft, JobSystem& jobs)
+    {
+        const auto size(m_Size);
+        const auto gravity(m_Gravity * ft);
+        {
+            TRACE_SCOPE("integrate");
+            jobs.parallelFor(0, m_Bodies.size(), bodiesPerJob, [this, ft, size, gravity](std::size_t first, std::size_t last)
+            {
+                if (gravity.x != 0.f || gravity.y != 0.f)
+                {
+                    for (auto i(first); i < last; ++i)
+                    {
+                        m_Bodies.vx[i] += gravity.x;
+                        m_Bodies.vy[i] += gravity.y;
+                    }
+                }
+                stepBodies(m_Isa, BodySpan::from(m_Bodies, first), last - first, ft, size.x, size.y);
+            });
+        }
+
+        if (m_Tiles != nullptr)
+        {
+            TRACE_SCOPE("tiles");
+            jobs.parallelFor(0, m_Bodies.size(), bodiesPerJob, [this](std::size_t first, std::size_t last) { collideTiles(first, last); });
+        }
+
+        {
+            TRACE_SCOPE("broadphase");
+            const auto start(HRClock::now());
+            m_Broadphase->findPairs(m_Bodies, m_Pairs, &jobs);
+            m_LastBroadphaseTime = HRClock::now() - start;
+            m_BroadphaseTime = m_BroadphaseTime == HRClock::duration::zero()
+                ? m_LastBroadphaseTime : (m_BroadphaseTime * 15 + m_LastBroadphaseTime) / 16;
+        }
+
+        {
+            TRACE_SCOPE("solve");
+            solveContacts(jobs);
+        }
+
+        if (!m_Constraints.empty())
+        {
+            TRACE_SCOPE("constraints");
+            m_Constraints.solve(m_Bodies, ft, &jobs);
+        }
+        ++m_Tick;
+    }
+
+private:
+    friend class PhysicsSnapshot;
+
+    // Pushes bodies out of the tiles they overlap and reflects the velocity off the pushed direction.
+    // Every body only depends on itself, so this is deterministic however the range is split.
+    inline void collideTiles(std::size_t first, std::size_t last) noexcept
+    {
+        auto& b(m_Bodies);
+        for (auto i(first); i < last; ++i)
+        {
+            Vec2f center{b.x[i], b.y[i]}, normal;
+            if (!m_Tiles->pushOutCircle(center, b.radius[i], normal)) continue;
+
+            b.x[i] = center.x;
+            b.y[i] = center.y;
+            const auto vn(b.vx[i] * normal.x + b.vy[i] * normal.y);
+            if (vn >= 0.f) continue;
+            b.vx[i] -= (1.f + m_Restitution) * vn * normal.x;
+            b.vy[i] -= (1.f + m_Restitution) * vn * normal.y;
+        }
+    }
+
+    inline void solveContacts(JobSystem& jobs)
+    {
+        const auto count(m_Bodies.size());
+
+        // Contacts of every body, in pair-list order
+        m_ContactStart.assign(count + 1, 0);
+        for (const auto& p : m_Pairs)
+        {
+            ++m_ContactStart[p.a + 1];
+            ++m_ContactStart[p.b + 1];
+        }
+        std::partial_sum(m_ContactStart.begin(), m_ContactStart.end(), m_ContactStart.begin());
+
+        m_ContactFill.assign(m_ContactStart.begin(), m_ContactStart.end() - 1);
+        m_Contacts.resize(m_Pairs.size() * 2);
+        for (std::uint32_t i(0); i < m_Pairs.size(); ++i)
+        {
+            m_Contacts[m_ContactFill[m_Pairs[i].a]++] = i;
+            m_Contacts[m_ContactFill[m_Pairs[i].b]++] = i;
+        }
+
+        // Every pair is evaluated once, against the state before the solve
+        m_PairResults.resize(m_Pairs.size());
+        jobs.parallelFor(0, m_Pairs.size(), pairsPerJob, [this](std::size_t first, std::size_t last)
+        {
+            for (auto i(first); i < last; ++i) m_PairResults[i] = evaluatePair(m_Pairs[i]);
+        });
+
+        jobs.parallelFor(0, count, bodiesPerJob, [this](std::size_t first, std::size_t last)
+        {
+            auto& b(m_Bodies);
+            for (auto i(first); i < last; ++i)
+            {
+                const auto contactCount(m_ContactStart[i + 1] - m_ContactStart[i]);
+                if (contactCount == 0) continue;
+
+                // Gathered in pair-list order, so the sums don't depend on how the bodies were split
+                auto dx(0.f), dy(0.f), dvx(0.f), dvy(0.f);
+                const auto invMass(1.f / (b.radius[i] * b.radius[i]));
+                for (auto c(m_ContactStart[i]); c < m_ContactStart[i + 1]; ++c)
+                {
+                    const auto& r(m_PairResults[m_Contacts[c]]);
+                    const auto share(m_Pairs[m_Contacts[c]].a == i ? -invMass : invMass);
+                    dx += r.separationX * share;
+                    dy += r.separationY * share;
+                    dvx += r.impulseX * share;
+                    dvy += r.impulseY * share;
+                }
+
+                // Averaged, since every contact was solved as if it were the body's only one
+                const auto weight(1.f / static_cast<float>(contactCount));
+                b.x[i] += dx * weight;
+                b.y[i] += dy * weight;
+                b.vx[i] += dvx * weight;
+                b.vy[i] += dvy * weight;
+            }
+        });
+    }
+
+    // Separation and impulse of one contact, before dividing by the mass of either body
+    struct PairResult
+    {
+        float separationX, separationY, impulseX, impulseY;
+    };
+
+    inline PairResult evaluatePair(const BodyPair& p) const noexcept
+    {
+        const auto& b(m_Bodies);
+        const auto dx(b.x[p.b] - b.x[p.a]), dy(b.y[p.b] - b.y[p.a]);
+        const auto r(b.radius[p.a] + b.radius[p.b]);
+        const auto dist2(dx*dx + dy*dy);
+        if (dist2 >= r*r || dist2 <= 0.f) return {0.f, 0.f, 0.f, 0.f};
+
+        // Mass is proportional to the disc area
+        const auto dist(std::sqrt(dist2));
+        const auto nx(dx / dist), ny(dy / dist);
+        const auto invMassSum(1.f / (b.radius[p.a] * b.radius[p.a]) + 1.f / (b.radius[p.b] * b.radius[p.b]));
+        const auto correction((r - dist) / invMassSum);
+
+        // Only approaching bodies get an impulse
+        const auto vn((b.vx[p.b] - b.vx[p.a]) * nx + (b.vy[p.b] - b.vy[p.a]) * ny);
+        const auto impulse(vn < 0.f ? -(1.f + m_Restitution) * vn / invMassSum : 0.f);
+
+        return {nx * correction, ny * correction, nx * impulse, ny * impulse};
+    }
+
+    Vec2f m_Size;
+    float m_CellSize{1.f};
+    StepIsa m_Isa{getBestStepIsa()};
+    float m_Restitution{1.f};
+    Vec2f m_Gravity;
+    std::mt19937 m_Rng;
+    std::uint64_t m_Tick{0};
+    BodyStore m_Bodies;
+    BroadphaseType m_BroadphaseType{BroadphaseType::Grid};
+    UPtr<Broadphase> m_Broadphase{mkUPtr<UniformGrid>(1.f, 1.f, 1.f)};
+    HRClock::duration m_LastBroadphaseTime{0}, m_BroadphaseTime{0};
+    std::vector<BodyPair> m_Pairs;
+    std::vector<std::uint32_t> m_ContactStart, m_ContactFill, m_Contacts;
+    std::vector<PairResult> m_PairResults;
+    ConstraintSolver m_Constraints;
+    const TileGrid* m_Tiles{nullptr};
+};
\ No newline at end of file
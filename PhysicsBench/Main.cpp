@@ -0,0 +1,545 @@
+#include "../Common/Common.hpp"
+#include "../Physics/Bodies.hpp"
+#include "../Physics/StepKernel.hpp"
+#include "../Physics/World.hpp"
+#include "../Physics/Snapshot.hpp"
+#include "../Physics/Particles.hpp"
+#include "../Physics/Constraints.hpp"
+#include "Suite.hpp"
+#include <random>
+
+// Micro-benchmark of the physics step kernel: ns per body per step for every ISA path this CPU supports,
+// single-threaded, over a range of body counts. Also checks that every path matches the scalar one bit for bit.
+// With --determinism, instead runs the full PhysicsWorld step with 1, 2, 4 and 8 threads and compares the
+// state hashes afterwards, then checks that rewinding to a snapshot and resimulating reproduces the same
+// state, with and without delta compression. With --broadphase, compares the pair generation cost of every broadphase on a dense
+// and on a sparse, fast-moving scene. With --particles, measures the particle update of a saturated pool that
+// spawns and kills thousands of particles per tick. With --constraints, compares solver iterations per ms of
+// the graph-colored constraint solver against the serial Gauss-Seidel reference on a cloth. With --tiles, measures
+// the TileGrid queries in millions per second and checks the raycasts against a fine march and the sweeps
+// against sampled overlap tests. With --suite, runs the full benchmark suite (see Suite.hpp).
+// Usage: PhysicsBench [body updates per measurement] [repeats]
+//        PhysicsBench --suite [options]
+//        PhysicsBench --determinism [ticks] [bodies]
+//        PhysicsBench --broadphase [ticks] [bodies]
+//        PhysicsBench --particles [ticks] [capacity]
+//        PhysicsBench --constraints [ticks] [cloth side]
+//        PhysicsBench --tiles [queries]
+
+constexpr float worldWidth{1024.f}, worldHeight{768.f}, bodyRadius{8.f}, timeStep{1.f/60.f};
+
+inline BodyStore makeBodies(std::size_t count)
+{
+    std::mt19937 rng{1234};
+    std::uniform_real_distribution<float> distX(bodyRadius, worldWidth - bodyRadius), distY(bodyRadius, worldHeight - bodyRadius),
+        distVel(-450.f, 450.f);
+
+    BodyStore bodies;
+    bodies.reserve(count);
+    for (std::size_t i(0); i < count; ++i)
+    {
+        const auto x(distX(rng)), y(distY(rng));
+        const auto vx(distVel(rng)), vy(distVel(rng));
+        bodies.add(x, y, vx, vy, bodyRadius);
+    }
+    return bodies;
+}
+
+// Fastest of `repeats` runs of `steps` steps, in ns per body per step
+inline double measure(StepIsa isa, BodyStore& bodies, std::size_t steps, std::size_t repeats)
+{
+    auto best(std::numeric_limits<double>::max());
+    for (std::size_t r(0); r < repeats; ++r)
+    {
+        const auto start(HRClock::now());
+        for (std::size_t s(0); s < steps; ++s)
+            stepBodies(isa, BodySpan::from(bodies, 0), bodies.size(), timeStep, worldWidth, worldHeight);
+        const auto ns(std::chrono::duration<double, std::nano>(HRClock::now() - start).count());
+        best = std::min(best, ns / static_cast<double>(steps * bodies.size()));
+    }
+    return best;
+}
+
+// Returns the state hash after `ticks` steps of a dense world with `threadCount` threads
+inline std::uint64_t simulate(std::size_t threadCount, std::size_t ticks, std::size_t bodies)
+{
+    JobSystem jobs{threadCount - 1};
+    PhysicsWorld world;
+    world.setBounds(2048.f, 1536.f, bodyRadius * 2.f);
+
+    world.seed(1234);
+    world.spawnUniform(bodies, bodyRadius, 450.f);
+    for (std::size_t i(0); i < ticks; ++i) world.step(timeStep, jobs);
+    return hashBodyState(world.getBodies());
+}
+
+// Runs `ticks` steps while recording every tick, rewinds half of them and resimulates; the final state
+// has to match the first run bit for bit
+inline bool checkRollback(std::size_t ticks, std::size_t bodies, bool compress)
+{
+    JobSystem jobs;
+    PhysicsWorld world;
+    world.setBounds(2048.f, 1536.f, bodyRadius * 2.f);
+    world.seed(1234);
+    world.spawnUniform(bodies, bodyRadius, 450.f);
+
+    SnapshotRing ring{ticks + 1};
+    ring.setDeltaCompression(compress);
+    ring.push(world);
+
+    auto captureTime(HRClock::duration::zero());
+    for (std::size_t i(0); i < ticks; ++i)
+    {
+        world.step(timeStep, jobs);
+        const auto start(HRClock::now());
+        ring.push(world);
+        captureTime += HRClock::now() - start;
+    }
+    const auto expected(hashBodyState(world.getBodies()));
+    const auto storedBytes(ring.getStoredBytes());
+
+    const auto rewound(ticks / 2);
+    const auto start(HRClock::now());
+    ring.rewind(world, rewound);
+    const auto rewindTime(HRClock::now() - start);
+    for (std::size_t i(0); i < rewound; ++i) world.step(timeStep, jobs);
+
+    const auto match(hashBodyState(world.getBodies()) == expected && world.getTick() == ticks);
+    std::cout << "rollback" << (compress ? " (delta)" : "") << ": "
+              << std::chrono::duration<double, std::micro>(captureTime).count() / ticks << " us/capture, "
+              << std::chrono::duration<double, std::micro>(rewindTime).count() << " us to rewind " << rewound << " ticks, "
+              << storedBytes / (ticks + 1) << " bytes/snapshot" << (match ? "" : "  MISMATCH") << "\n";
+    return match;
+}
+
+inline int runDeterminismCheck(std::size_t ticks, std::size_t bodies)
+{
+    std::cout << "determinism: " << bodies << " bodies, " << ticks << " ticks\n" << std::hex;
+
+    std::uint64_t reference{0};
+    auto mismatch(false);
+    for (std::size_t threads : {1u, 2u, 4u, 8u})
+    {
+        const auto hash(simulate(threads, ticks, bodies));
+        if (threads == 1) reference = hash;
+        const auto match(hash == reference);
+        mismatch |= !match;
+        std::cout << std::dec << threads << " threads: " << std::hex << hash << (match ? "" : "  MISMATCH") << "\n";
+    }
+
+    std::cout << std::dec;
+    for (auto compress : {false, true})
+        mismatch |= !checkRollback(ticks, bodies, compress);
+
+    std::cout << (mismatch ? "FAILED" : "OK") << std::endl;
+    return mismatch ? 1 : 0;
+}
+
+// Average broadphase time and pair count per tick of a square world where the bodies cover `coverage` of the area
+inline void compareBroadphase(BroadphaseType type, std::size_t ticks, std::size_t bodies, float coverage, float maxSpeed)
+{
+    JobSystem jobs;
+    PhysicsWorld world;
+    const auto side(std::sqrt(static_cast<float>(bodies) * bodyRadius * bodyRadius * 3.14159f / coverage));
+    world.setBounds(side, side, bodyRadius * 2.f);
+    world.setBroadphase(type);
+
+    world.seed(1234);
+    world.spawnUniform(bodies, bodyRadius, maxSpeed);
+
+    auto broadphaseTime(HRClock::duration::zero());
+    std::size_t pairs{0};
+    for (std::size_t i(0); i < ticks; ++i)
+    {
+        world.step(timeStep, jobs);
+        broadphaseTime += world.getLastBroadphaseTime();
+        pairs += world.getPairs().size();
+    }
+
+    std::cout << std::setw(8) << world.getBroadphase().getName() << std::setw(10) << coverage << std::setw(10) << maxSpeed
+              << std::setw(12) << std::chrono::duration<double, std::milli>(broadphaseTime).count() / ticks
+              << std::setw(12) << pairs / ticks << "\n";
+}
+
+// Continuous emitters that together spawn more than the pool can hold, so it stays full
+inline int runParticleBench(std::size_t ticks, std::size_t capacity)
+{
+    JobSystem jobs;
+    ParticleSystem particles{capacity};
+    particles.seed(1234);
+
+    EmitterSettings settings;
+    settings.minLifetime = .25f;
+    settings.maxLifetime = 1.f;
+    settings.gravity = {0.f, 600.f};
+    settings.speed = {{0.f, 1.f}, {1.f, .3f}};
+    settings.size = {{0.f, 3.f}, {.5f, 2.f}, {1.f, 1.f}};
+    settings.color = {{0.f, sf::Color::White}, {.5f, sf::Color::Yellow}, {1.f, sf::Color::Transparent}};
+    settings.rate = static_cast<float>(capacity) * 2.f / 4.f;
+    for (auto i(0); i < 4; ++i)
+    {
+        const auto id(particles.addEmitter(settings));
+        particles.setEmitterPosition(id, {256.f * (i + 1), 384.f});
+        particles.setEmitterEnabled(id, true);
+    }
+
+    // Fill the pool first
+    for (auto i(0); i < 120; ++i) particles.update(timeStep, jobs);
+
+    const auto memory(particles.getMemoryUsage());
+    const auto spawned(particles.getSpawnedCount()), killed(particles.getKilledCount());
+    std::size_t live{0};
+    const auto start(HRClock::now());
+    for (std::size_t i(0); i < ticks; ++i)
+    {
+        particles.update(timeStep, jobs);
+        live += particles.size();
+    }
+    const auto ms(std::chrono::duration<double, std::milli>(HRClock::now() - start).count());
+
+    std::cout << std::fixed << std::setprecision(3) << "particles: capacity " << capacity << ", " << ticks << " ticks\n"
+              << "live/tick: " << live / ticks << ", spawned/tick: " << (particles.getSpawnedCount() - spawned) / ticks
+              << ", killed/tick: " << (particles.getKilledCount() - killed) / ticks << "\n"
+              << "update: " << ms / ticks << " ms/tick, " << ms * 1e6 / static_cast<double>(live) << " ns/particle\n"
+              << "pool memory: " << memory << " bytes" << (particles.getMemoryUsage() == memory ? "" : " (grew!)") << std::endl;
+    return particles.getMemoryUsage() == memory ? 0 : 1;
+}
+
+// A square cloth with structural and shear links, hanging from every tenth node of its top row
+inline void makeCloth(std::size_t side, BodyStore& bodies, ConstraintSolver& constraints)
+{
+    constexpr float spacing{10.f};
+    for (std::size_t row(0); row < side; ++row)
+        for (std::size_t col(0); col < side; ++col)
+        {
+            const auto node(static_cast<std::uint32_t>(bodies.add(col * spacing, row * spacing, 0.f, 0.f, 4.f)));
+            const auto up(node - static_cast<std::uint32_t>(side));
+            if (col > 0) constraints.addDistance(node - 1, node, spacing);
+            if (row > 0) constraints.addDistance(up, node, spacing);
+            if (row > 0 && col > 0) constraints.addDistance(up - 1, node, spacing * 1.41421356f, .5f);
+            if (row > 0 && col + 1 < side) constraints.addDistance(up + 1, node, spacing * 1.41421356f, .5f);
+            if (row == 0 && col % 10 == 0) constraints.addPin(node, {bodies.x[node], bodies.y[node]});
+        }
+}
+
+// Simulates the cloth under gravity for `ticks` steps with `solve`, prints the solver throughput and the
+// final constraint error, and returns the state hash
+template <typename TSolve>
+inline std::uint64_t measureConstraints(const char* name, BodyStore bodies, ConstraintSolver constraints, std::size_t ticks, TSolve&& solve)
+{
+    auto solveTime(HRClock::duration::zero());
+    for (std::size_t t(0); t < ticks; ++t)
+    {
+        for (std::size_t i(0); i < bodies.size(); ++i)
+        {
+            bodies.vy[i] += 500.f * timeStep;
+            bodies.prevX[i] = bodies.x[i];
+            bodies.prevY[i] = bodies.y[i];
+            bodies.x[i] += bodies.vx[i] * timeStep;
+            bodies.y[i] += bodies.vy[i] * timeStep;
+        }
+
+        const auto start(HRClock::now());
+        solve(constraints, bodies);
+        solveTime += HRClock::now() - start;
+    }
+
+    const auto ms(std::chrono::duration<double, std::milli>(solveTime).count());
+    std::cout << std::setw(24) << name << std::setw(14) << ticks * constraints.getIterations() / ms
+              << std::setw(12) << ms / ticks << std::setw(12) << constraints.getError(bodies) << "\n";
+    return hashBodyState(bodies);
+}
+
+// A hub linked to more bodies than there are parallel colors, so the extra links land in the serial batch.
+// Every path has to relax that batch one constraint after another; returns whether they agree.
+inline bool checkSerialBatch()
+{
+    BodyStore bodies;
+    ConstraintSolver constraints;
+    bodies.add(0.f, 0.f, 0.f, 0.f, 4.f);
+    for (std::uint32_t i(1); i <= ConstraintSolver::maxParallelColors + 16; ++i)
+    {
+        bodies.add(std::cos(i * .1f) * 30.f, std::sin(i * .1f) * 30.f, 0.f, 0.f, 4.f);
+        constraints.addDistance(0, i, 10.f + i * .1f);
+    }
+
+    std::uint64_t reference{0};
+    auto match(true);
+    for (auto isa : {StepIsa::Scalar, StepIsa::AVX2})
+    {
+        if (!isStepIsaSupported(isa)) continue;
+        auto b(bodies);
+        auto c(constraints);
+        c.setIsa(isa);
+        for (auto t(0); t < 10; ++t) c.solve(b, timeStep, nullptr);
+        if (isa == StepIsa::Scalar) reference = hashBodyState(b);
+        else match &= hashBodyState(b) == reference;
+    }
+    return match;
+}
+
+inline int runConstraintBench(std::size_t ticks, std::size_t side)
+{
+    BodyStore bodies;
+    ConstraintSolver constraints;
+    makeCloth(side, bodies, constraints);
+    constraints.setIterations(8);
+
+    JobSystem jobs;
+    std::cout << std::fixed << std::setprecision(4) << "constraints: " << constraints.getDistances().size() << " links, "
+              << bodies.size() << " bodies, " << constraints.getColorCount() << " colors, " << ticks << " ticks, "
+              << jobs.getThreadCount() << " threads\n"
+              << std::setw(24) << "solver" << std::setw(14) << "iter/ms" << std::setw(12) << "ms/tick" << std::setw(12) << "error" << "\n";
+
+    measureConstraints("gauss-seidel", bodies, constraints, ticks, [](ConstraintSolver& c, BodyStore& b) { c.solveGaussSeidel(b, timeStep); });
+
+    constraints.setIsa(StepIsa::Scalar);
+    const auto reference(measureConstraints("colored scalar", bodies, constraints, ticks,
+        [](ConstraintSolver& c, BodyStore& b) { c.solve(b, timeStep, nullptr); }));
+
+    auto mismatch(false);
+    if (isStepIsaSupported(StepIsa::AVX2))
+    {
+        constraints.setIsa(StepIsa::AVX2);
+        mismatch |= reference != measureConstraints("colored avx2", bodies, constraints, ticks,
+            [](ConstraintSolver& c, BodyStore& b) { c.solve(b, timeStep, nullptr); });
+    }
+
+    mismatch |= reference != measureConstraints("colored parallel", bodies, constraints, ticks,
+        [&jobs](ConstraintSolver& c, BodyStore& b) { c.solve(b, timeStep, &jobs); });
+
+    mismatch |= !checkSerialBatch();
+
+    if (mismatch) std::cout << "MISMATCH: colored solver results differ between paths" << std::endl;
+    return mismatch ? 1 : 0;
+}
+
+constexpr unsigned int gridSide{512};
+constexpr float gridTileSize{32.f}, gridSolidShare{.25f};
+
+// Scattered solid tiles, 25% of them
+inline TileGrid makeTileGrid()
+{
+    std::mt19937 rng{1234};
+    std::uniform_real_distribution<float> dist(0.f, 1.f);
+    std::vector<std::uint16_t> tiles(static_cast<std::size_t>(gridSide) * gridSide);
+    for (auto& tile : tiles) tile = dist(rng) < gridSolidShare ? 1 : 0;
+
+    TileGrid grid;
+    grid.build(tiles.data(), gridSide, gridSide, {gridTileSize, gridTileSize}, [](std::uint16_t tile) { return tile != 0; });
+    return grid;
+}
+
+// Runs query(i) for every i in [0, count) and prints the throughput; the hit count keeps the queries from
+// being optimized away
+template <typename TQuery>
+inline void measureTileQuery(const char* name, std::size_t count, TQuery&& query)
+{
+    std::size_t hits{0};
+    const auto start(HRClock::now());
+    for (std::size_t i(0); i < count; ++i) hits += query(i) ? 1 : 0;
+    const auto seconds(std::chrono::duration<double>(HRClock::now() - start).count());
+    std::cout << std::setw(20) << name << std::setw(12) << count / seconds * 1e-6 << std::setw(10) << 100.0 * hits / count << "%\n";
+}
+
+// Distance along the normalized ray to where it enters the tile, in double precision
+inline double getRayEntry(Vec2f origin, Vec2f direction, Vec2i tile)
+{
+    auto entry(0.0), exit(std::numeric_limits<double>::max());
+    const auto slab([&entry, &exit](double origin, double direction, double min, double max)
+    {
+        if (direction == 0.0) return;
+        const auto t0((min - origin) / direction), t1((max - origin) / direction);
+        entry = std::max(entry, std::min(t0, t1));
+        exit = std::min(exit, std::max(t0, t1));
+    });
+    slab(origin.x, direction.x, tile.x * gridTileSize, (tile.x + 1) * gridTileSize);
+    slab(origin.y, direction.y, tile.y * gridTileSize, (tile.y + 1) * gridTileSize);
+    return entry <= exit ? entry : -1.0;
+}
+
+// Checks `rays` DDA raycasts against marches in steps of 1/64 tile, and `sweeps` circle sweeps against overlap
+// tests at 256 points of their path. Returns the number of disagreements.
+inline std::size_t validateTileGrid(const TileGrid& grid, std::size_t rays, std::size_t sweeps)
+{
+    std::mt19937 rng{4321};
+    const auto size(gridSide * gridTileSize);
+    std::uniform_real_distribution<float> distPos(-gridTileSize, size + gridTileSize), distOffset(-200.f, 200.f), distRadius(2.f, 24.f);
+
+    constexpr float maxDistance{400.f}, step{gridTileSize / 64.f};
+    std::size_t mismatches{0};
+    for (std::size_t i(0); i < rays; ++i)
+    {
+        const Vec2f origin(distPos(rng), distPos(rng)), direction(distOffset(rng), distOffset(rng));
+        const auto length(std::hypot(direction.x, direction.y));
+        if (length == 0.f) continue;
+        const auto hit(grid.raycast(origin, direction, maxDistance));
+
+        // The march may not find a solid tile before the hit; it can miss one where the ray grazes a corner,
+        // so the hit tile is checked with an exact slab test instead
+        auto marched(-1.f);
+        for (auto t(0.f); t <= maxDistance && marched < 0.f; t += step)
+        {
+            const auto tile(grid.getTileAt(origin + direction * (t / length)));
+            if (grid.isSolid(tile.x, tile.y)) marched = t;
+        }
+        if (marched >= 0.f && (!hit.hit || marched < hit.t - step)) mismatches++;
+        else if (hit.hit && (!grid.isSolid(hit.tile.x, hit.tile.y) || std::abs(getRayEntry(origin, direction / length, hit.tile) - hit.t) > .05))
+            mismatches++;
+    }
+
+    for (std::size_t i(0); i < sweeps; ++i)
+    {
+        const Vec2f from(distPos(rng), distPos(rng));
+        const auto to(from + Vec2f{distOffset(rng), distOffset(rng)});
+        const auto radius(distRadius(rng));
+        const auto hit(grid.sweepCircle(from, to, radius));
+
+        // The first sampled point that overlaps may not come before the hit, and the circle may not overlap just before it
+        constexpr auto samples(256);
+        for (auto s(0); s <= samples; ++s)
+        {
+            const auto t(static_cast<float>(s) / samples);
+            const auto overlapping(grid.overlapsCircle(from + (to - from) * t, radius * .999f));
+            if (overlapping && (!hit.hit || hit.t > t + 1e-4f))
+            {
+                mismatches++;
+                break;
+            }
+            if (hit.hit && t >= hit.t) break;
+        }
+        if (hit.hit && hit.t > 1e-3f && grid.overlapsCircle(from + (to - from) * (hit.t - 1e-3f), radius * .999f)) mismatches++;
+    }
+    return mismatches;
+}
+
+inline int runTileBench(std::size_t queries)
+{
+    const auto grid(makeTileGrid());
+    const auto size(gridSide * gridTileSize);
+
+    // The inputs are generated up front so only the queries are timed
+    std::mt19937 rng{1234};
+    std::uniform_real_distribution<float> distPos(0.f, size), distOffset(-256.f, 256.f), distRadius(4.f, 24.f);
+    std::vector<Vec2f> points(queries), offsets(queries);
+    std::vector<float> radii(queries);
+    for (std::size_t i(0); i < queries; ++i)
+    {
+        points[i] = {distPos(rng), distPos(rng)};
+        offsets[i] = {distOffset(rng), distOffset(rng)};
+        radii[i] = distRadius(rng);
+    }
+
+    JobSystem jobs;
+    std::cout << std::fixed << std::setprecision(3) << "tiles: " << gridSide << "x" << gridSide << " grid, " << gridSolidShare * 100.f
+              << "% solid, " << queries << " queries\n" << std::setw(20) << "query" << std::setw(12) << "Mq/s" << std::setw(11) << "hits" << "\n";
+
+    measureTileQuery("overlaps", queries, [&](std::size_t i)
+    {
+        return grid.overlaps({points[i].x - radii[i], points[i].y - radii[i], radii[i] * 2.f, radii[i] * 2.f});
+    });
+    measureTileQuery("overlapsCircle", queries, [&](std::size_t i) { return grid.overlapsCircle(points[i], radii[i]); });
+    measureTileQuery("pushOutCircle", queries, [&](std::size_t i)
+    {
+        auto center(points[i]);
+        Vec2f normal;
+        return grid.pushOutCircle(center, radii[i], normal);
+    });
+    measureTileQuery("raycast", queries, [&](std::size_t i) { return grid.raycast(points[i], offsets[i], 256.f).hit; });
+    measureTileQuery("sweepCircle", queries, [&](std::size_t i) { return grid.sweepCircle(points[i], points[i] + offsets[i], radii[i]).hit; });
+
+    // Queries only read the grid, so they run on every thread without synchronization
+    std::atomic<std::size_t> parallelHits{0};
+    const auto start(HRClock::now());
+    jobs.parallelFor(0, queries, 4096, [&](std::size_t first, std::size_t last)
+    {
+        std::size_t hits{0};
+        for (auto i(first); i < last; ++i) hits += grid.raycast(points[i], offsets[i], 256.f).hit ? 1 : 0;
+        parallelHits += hits;
+    });
+    const auto seconds(std::chrono::duration<double>(HRClock::now() - start).count());
+    std::cout << std::setw(20) << "raycast parallel" << std::setw(12) << queries / seconds * 1e-6 << std::setw(10)
+              << 100.0 * parallelHits / queries << "%  (" << jobs.getThreadCount() << " threads)\n";
+
+    const auto mismatches(validateTileGrid(grid, 20000, 20000));
+    std::cout << (mismatches == 0 ? "OK" : "MISMATCH") << ": " << mismatches << " queries disagree with the reference" << std::endl;
+    return mismatches == 0 ? 0 : 1;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc > 1 && std::strcmp(argv[1], "--suite") == 0) return runSuite(argc, argv);
+
+    if (argc > 1 && std::strcmp(argv[1], "--broadphase") == 0)
+    {
+        const std::size_t ticks(argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 120);
+        const std::size_t bodies(argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 50000);
+
+        std::cout << bodies << " bodies, " << ticks << " ticks\n" << std::fixed << std::setprecision(3)
+                  << std::setw(8) << "type" << std::setw(10) << "coverage" << std::setw(10) << "speed"
+                  << std::setw(12) << "ms/tick" << std::setw(12) << "pairs/tick" << "\n";
+        for (auto type : {BroadphaseType::Grid, BroadphaseType::SweepAndPrune})
+        {
+            compareBroadphase(type, ticks, bodies, .4f, 450.f);
+            compareBroadphase(type, ticks, bodies, .02f, 3000.f);
+        }
+        return 0;
+    }
+
+    if (argc > 1 && std::strcmp(argv[1], "--constraints") == 0)
+    {
+        const std::size_t ticks(argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 300);
+        const std::size_t side(argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 100);
+        return runConstraintBench(ticks, side);
+    }
+
+    if (argc > 1 && std::strcmp(argv[1], "--tiles") == 0)
+        return runTileBench(argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 4000000);
+
+    if (argc > 1 && std::strcmp(argv[1], "--particles") == 0)
+    {
+        const std::size_t ticks(argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 600);
+        const std::size_t capacity(argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 262144);
+        return runParticleBench(ticks, capacity);
+    }
+
+    if (argc > 1 && std::strcmp(argv[1], "--determinism") == 0)
+    {
+        const std::size_t ticks(argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 300);
+        const std::size_t bodies(argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 5000);
+        return runDeterminismCheck(ticks, bodies);
+    }
+
+    const std::size_t bodyUpdates(argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 50000000);
+    const std::size_t repeats(argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 3);
+
+    std::vector<StepIsa> isas;
+    for (auto isa : {StepIsa::Scalar, StepIsa::SSE2, StepIsa::AVX2})
+        if (isStepIsaSupported(isa)) isas.emplace_back(isa);
+
+    auto mismatch(false);
+    std::cout << std::fixed << std::setprecision(3) << std::setw(10) << "bodies";
+    for (auto isa : isas) std::cout << std::setw(10) << getStepIsaName(isa);
+    std::cout << "   (ns/body/step)\n";
+
+    for (std::size_t count : {1024u, 16384u, 262144u, 1048576u})
+    {
+        const auto steps(std::max<std::size_t>(bodyUpdates / count, 1));
+        std::cout << std::setw(10) << count;
+
+        std::uint64_t reference{0};
+        for (auto isa : isas)
+        {
+            auto bodies(makeBodies(count));
+            std::cout << std::setw(10) << measure(isa, bodies, steps, repeats) << std::flush;
+
+            const auto hash(hashBodyState(bodies));
+            if (isa == StepIsa::Scalar) reference = hash;
+            else if (hash != reference) mismatch = true;
+        }
+        std::cout << "\n";
+    }
+
+    if (mismatch) std::cout << "MISMATCH: SIMD results differ from the scalar path" << std::endl;
+    return mismatch ? 1 : 0;
+}
\ No newline at end of file
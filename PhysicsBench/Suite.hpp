@@ -0,0 +1,163 @@
+#pragma once
+#include "../Common/Common.hpp"
+#include "../Physics/World.hpp"
+#include <random>
+
+// Headless benchmark suite: runs the full PhysicsWorld step with a fixed seed over a sweep of body counts
+// (1k to 1M), uniform and clustered distributions and every broadphase. Reports ns per body per tick, the
+// tick time percentiles and the memory footprint as CSV or JSON, so results can be tracked across revisions.
+// The world grows with the body count so the bodies always cover the same fraction of it.
+
+struct SuiteCase
+{
+    BroadphaseType broadphase;
+    bool clustered;
+    std::size_t bodies;
+};
+
+struct SuiteResult
+{
+    SuiteCase config;
+    std::size_t ticks;
+    double nsPerBodyTick, p50Ms, p95Ms, p99Ms, maxMs, pairsPerTick;
+    std::size_t memoryBytes;
+};
+
+struct SuiteOptions
+{
+    std::uint32_t seed{1234};
+    std::size_t threads{JobSystem::getDefaultWorkerCount() + 1};
+    std::size_t ticks{0};                      // 0: pick per case, about 10M body updates
+    std::size_t warmupTicks{10};
+    std::size_t minBodies{1000}, maxBodies{1000000};
+    float coverage{.3f};
+    bool json{false};
+    std::string outPath;
+    std::vector<BroadphaseType> broadphases{BroadphaseType::Grid, BroadphaseType::SweepAndPrune};
+};
+
+inline const char* getBroadphaseName(BroadphaseType type) noexcept
+{
+    return type == BroadphaseType::SweepAndPrune ? "sap" : "grid";
+}
+
+inline SuiteResult runSuiteCase(const SuiteCase& config, const SuiteOptions& options, JobSystem& jobs)
+{
+    constexpr float radius{8.f}, maxSpeed{450.f}, timeStep{1.f/60.f};
+
+    PhysicsWorld world;
+    const auto side(std::sqrt(static_cast<float>(config.bodies) * radius * radius * 3.14159f / options.coverage));
+    world.setBounds(side, side, radius * 2.f);
+    world.setBroadphase(config.broadphase);
+
+    world.seed(options.seed);
+    if (config.clustered) world.spawnClustered(config.bodies, std::max<std::size_t>(config.bodies / 2000, 1), .02f, radius, maxSpeed);
+    else world.spawnUniform(config.bodies, radius, maxSpeed);
+
+    for (std::size_t i(0); i < options.warmupTicks; ++i) world.step(timeStep, jobs);
+
+    const auto ticks(options.ticks > 0 ? options.ticks : std::min<std::size_t>(std::max<std::size_t>(10000000 / config.bodies, 10), 600));
+    std::vector<double> tickMs(ticks);
+    std::size_t pairs{0};
+    auto total(0.0);
+    for (std::size_t i(0); i < ticks; ++i)
+    {
+        const auto start(HRClock::now());
+        world.step(timeStep, jobs);
+        tickMs[i] = std::chrono::duration<double, std::milli>(HRClock::now() - start).count();
+        total += tickMs[i];
+        pairs += world.getPairs().size();
+    }
+
+    std::sort(tickMs.begin(), tickMs.end());
+    const auto percentile([&tickMs](double p) { return tickMs[std::min(static_cast<std::size_t>(p * tickMs.size()), tickMs.size() - 1)]; });
+
+    return {config, ticks, total * 1e6 / (static_cast<double>(ticks) * config.bodies),
+        percentile(.5), percentile(.95), percentile(.99), tickMs.back(),
+        static_cast<double>(pairs) / ticks, world.getMemoryUsage()};
+}
+
+inline void writeSuiteCsv(std::ostream& os, const SuiteOptions& options, const std::vector<SuiteResult>& results)
+{
+    os << "broadphase,distribution,bodies,ticks,seed,threads,isa,ns_per_body_tick,tick_p50_ms,tick_p95_ms,tick_p99_ms,tick_max_ms,pairs_per_tick,memory_bytes\n";
+    for (const auto& r : results)
+    {
+        os << getBroadphaseName(r.config.broadphase) << ',' << (r.config.clustered ? "clustered" : "uniform") << ','
+           << r.config.bodies << ',' << r.ticks << ',' << options.seed << ',' << options.threads << ','
+           << getStepIsaName(getBestStepIsa()) << ',' << r.nsPerBodyTick << ',' << r.p50Ms << ',' << r.p95Ms << ','
+           << r.p99Ms << ',' << r.maxMs << ',' << r.pairsPerTick << ',' << r.memoryBytes << '\n';
+    }
+}
+
+inline void writeSuiteJson(std::ostream& os, const SuiteOptions& options, const std::vector<SuiteResult>& results)
+{
+    os << "{\n  \"seed\": " << options.seed << ",\n  \"threads\": " << options.threads
+       << ",\n  \"isa\": \"" << getStepIsaName(getBestStepIsa()) << "\",\n  \"results\": [\n";
+    for (std::size_t i(0); i < results.size(); ++i)
+    {
+        const auto& r(results[i]);
+        os << "    {\"broadphase\": \"" << getBroadphaseName(r.config.broadphase) << "\", \"distribution\": \""
+           << (r.config.clustered ? "clustered" : "uniform") << "\", \"bodies\": " << r.config.bodies
+           << ", \"ticks\": " << r.ticks << ", \"ns_per_body_tick\": " << r.nsPerBodyTick
+           << ", \"tick_ms\": {\"p50\": " << r.p50Ms << ", \"p95\": " << r.p95Ms << ", \"p99\": " << r.p99Ms << ", \"max\": " << r.maxMs << "}"
+           << ", \"pairs_per_tick\": " << r.pairsPerTick << ", \"memory_bytes\": " << r.memoryBytes << "}"
+           << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    os << "  ]\n}\n";
+}
+
+// Usage: PhysicsBench --suite [--format csv|json] [--out FILE] [--seed N] [--threads N] [--ticks N]
+//                             [--min-bodies N] [--max-bodies N] [--broadphase grid|sap|all]
+inline int runSuite(int argc, char* argv[])
+{
+    SuiteOptions options;
+    for (auto i(2); i + 1 < argc; ++i)
+    {
+        const auto value(argv[i + 1]);
+        if (std::strcmp(argv[i], "--format") == 0) options.json = std::strcmp(value, "json") == 0;
+        else if (std::strcmp(argv[i], "--out") == 0) options.outPath = value;
+        else if (std::strcmp(argv[i], "--seed") == 0) options.seed = static_cast<std::uint32_t>(std::strtoul(value, nullptr, 10));
+        else if (std::strcmp(argv[i], "--threads") == 0) options.threads = std::max<std::size_t>(std::strtoul(value, nullptr, 10), 1);
+        else if (std::strcmp(argv[i], "--ticks") == 0) options.ticks = std::strtoul(value, nullptr, 10);
+        else if (std::strcmp(argv[i], "--min-bodies") == 0) options.minBodies = std::strtoul(value, nullptr, 10);
+        else if (std::strcmp(argv[i], "--max-bodies") == 0) options.maxBodies = std::strtoul(value, nullptr, 10);
+        else if (std::strcmp(argv[i], "--broadphase") == 0)
+        {
+            if (std::strcmp(value, "grid") == 0) options.broadphases = {BroadphaseType::Grid};
+            else if (std::strcmp(value, "sap") == 0) options.broadphases = {BroadphaseType::SweepAndPrune};
+        }
+        else continue;
+        ++i;
+    }
+
+    JobSystem jobs{options.threads - 1};
+    std::vector<SuiteResult> results;
+    for (std::size_t bodies : {1000u, 3000u, 10000u, 30000u, 100000u, 300000u, 1000000u})
+    {
+        if (bodies < options.minBodies || bodies > options.maxBodies) continue;
+        for (auto broadphase : options.broadphases)
+            for (auto clustered : {false, true})
+            {
+                // Progress goes to stderr, so stdout stays machine-readable
+                std::cerr << getBroadphaseName(broadphase) << ' ' << (clustered ? "clustered" : "uniform") << ' ' << bodies << std::endl;
+                results.emplace_back(runSuiteCase({broadphase, clustered, bodies}, options, jobs));
+            }
+    }
+
+    std::ofstream file;
+    if (!options.outPath.empty())
+    {
+        file.open(options.outPath);
+        if (!file)
+        {
+            std::cerr << "Could not open " << options.outPath << std::endl;
+            return 1;
+        }
+    }
+
+    auto& os(options.outPath.empty() ? std::cout : static_cast<std::ostream&>(file));
+    os << std::setprecision(6);
+    if (options.json) writeSuiteJson(os, options, results);
+    else writeSuiteCsv(os, options, results);
+    return 0;
+}
\ No newline at end of file
@@ -15,7 +15,7 @@ int main()
         shape.setOrigin(rectWidth/2.f, rectHeight/2.f);
         shape.setFillColor(sf::Color::Black);
     };
-    game.onDraw = [&shape](sf::RenderTarget& target)
+    game.onDraw = [&shape](sf::RenderTarget& target, float)
     {
         target.draw(shape);
     };
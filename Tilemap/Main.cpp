@@ -1,6 +1,9 @@
-#include "Tilemap.hpp"
+#include "StreamingTilemap.hpp"
 
 constexpr float rectWidth{100}, rectHeight{100};
+constexpr float cameraSpeed{1200.f};
+constexpr unsigned int blastSize{8};
+constexpr std::uint16_t firstWallTile{1}, lastWallTile{8};
 
 class TilemapGame
 {
@@ -15,57 +18,138 @@ public:
         {
             onUpdate(ft);
         };
-        m_Game.onDraw = [this](sf::RenderTarget& target)
+        m_Game.onUpdateVariable = [this](float dt)
+        {
+            onUpdateVariable(dt);
+        };
+        m_Game.onDraw = [this](sf::RenderTarget& target, float)
         {
             onDraw(target);
         };
+        m_Game.onEvent = [this](const sf::Event& event)
+        {
+            if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F3)
+                m_ShowProfile = !m_ShowProfile;
+            else if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::V)
+                m_Tilemap.setVertexBuffers(!m_Tilemap.usesVertexBuffers());
+            else if (event.type == sf::Event::MouseButtonPressed)
+                onClick(event.mouseButton);
+        };
         m_Game.onFpsUpdated = [this](int newFps)
         {
-            m_FpsText.setString("FPS: " + std::to_string(newFps));
+            FrameString text{m_Game.getFrameArena()};
+            char fps[16];
+            std::snprintf(fps, sizeof(fps), "%d", newFps);
+            text += "FPS: ";
+            text += fps;
+
+            if (m_Streaming)
+            {
+                char stream[256];
+                std::snprintf(stream, sizeof(stream), "\nChunks: %zu drawn, %zu / %zu resident, %zu queued (%.1f MB)"
+                    "\nStalls: %zu now, %zu total\nLoad latency: %.2f ms avg, %.2f ms max\nLoaded: %zu, evicted: %zu",
+                    m_Stream.getDrawnChunkCount(), m_Stream.getResidentChunkCount(), m_Stream.getCacheCapacity(), m_Stream.getQueuedChunkCount(),
+                    m_Stream.getMemoryUsage() / (1024.f * 1024.f), m_Stream.getStalledChunkCount(), m_Stream.getStallCount(),
+                    m_Stream.getAverageLoadLatency(), m_Stream.getMaxLoadLatency(), m_Stream.getLoadedChunkCount(), m_Stream.getEvictedChunkCount());
+                text += stream;
+            }
+            else
+            {
+                char chunks[64];
+                std::snprintf(chunks, sizeof(chunks), "\nChunks: %zu / %zu", m_Tilemap.getDrawnChunkCount(), m_Tilemap.getChunkCount());
+                text += chunks;
+
+                char uploaded[96];
+                std::snprintf(uploaded, sizeof(uploaded), "\n%s: %zu bytes uploaded", m_Tilemap.usesVertexBuffers() ? "Vertex buffers" : "Vertex arrays",
+                    m_Tilemap.getUploadedBytes());
+                text += uploaded;
+            }
+            if (m_ShowProfile)
+            {
+                text += '\n';
+                text += m_Game.getProfiler().getSummary().c_str();
+            }
+            m_FpsText.setString(text.c_str());
         };
     }
 
-    inline void run() { m_Game.run(); }
+    inline int run(int argc, char* argv[]) { return m_Game.run(argc, argv); }
+
+    // Client-side vertex arrays instead of GPU vertex buffers
+    inline void setVertexBuffers(bool enabled) noexcept { m_VertexBuffers = enabled; }
+
+    inline void setMapPath(std::string path) { m_MapPath = std::move(path); }
+
+    // Writes the map to `path` once it is loaded, after --map has been applied
+    inline void setExportPath(std::string path) { m_ExportPath = std::move(path); }
+
+    // Streams the map file instead of loading it whole; the map can't be edited then
+    inline void setStreaming(std::size_t cacheChunks) noexcept
+    {
+        m_Streaming = true;
+        m_Stream.setCacheCapacity(cacheChunks);
+    }
+
+    // Scrolls the camera diagonally on its own
+    inline void setFlying(bool flying) noexcept { m_Flying = flying; }
+
+    // Replaces the loaded map with one of the given size that repeats it
+    inline void setMapSize(unsigned int width, unsigned int height) noexcept
+    {
+        m_MapWidth = width;
+        m_MapHeight = height;
+    }
 
 private:
     inline void onLoadContent()
     {
-        static const int level[32*24] =
-        {
-            1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 3,
-            8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 4,
-            8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 4,
-            8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 4,
-            8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 4,
-            8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 4,
-            8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 4,
-            8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 4,
-            8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 4,
-            8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 4,
-            8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 4,
-            8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 4,
-            8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 4,
-            8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 4,
-            8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 4,
-            8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 4,
-            8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 4,
-            8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 4,
-            8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 4,
-            8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 4,
-            8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 4,
-            8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 4,
-            8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 4,
-            7, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 5
-        };
-
-        m_Sansation.loadFromFile("Assets/sansation.ttf");
+        // Both decode on the resource cache's thread while the map loads
+        auto& resources(m_Game.getResources());
+        m_Sansation = resources.loadFont("Assets/Sansation.ttf", [this](const sf::Font& font) { m_FpsText.setFont(font); });
+        const auto tileset(resources.loadTexture("Assets/tileset.png"));
+        m_Tilemap.setTileset(tileset);
+        m_Stream.setTileset(tileset);
 
-        m_FpsText.setFont(m_Sansation);
         m_FpsText.setCharacterSize(14u);
         m_FpsText.setPosition(3.f, 3.f);
         m_FpsText.setColor(sf::Color::Black);
 
-        m_Tilemap.load(level, 32, 24);
+        const auto windowWidth(static_cast<float>(m_Game.getWindowWidth())), windowHeight(static_cast<float>(m_Game.getWindowHeight()));
+        m_Camera.reset({0.f, 0.f, windowWidth, windowHeight});
+
+        if (m_Streaming)
+        {
+            m_Stream.open(m_MapPath);
+            return;
+        }
+
+        const auto loaded(m_Tilemap.loadFromFile(m_MapPath, &m_Game.getJobs()));
+        if (loaded && m_MapWidth > 0 && m_MapHeight > 0)
+        {
+            const auto width(m_Tilemap.getWidth()), height(m_Tilemap.getHeight());
+            std::vector<std::vector<std::uint16_t>> layers(m_Tilemap.getLayerCount());
+            std::vector<const std::uint16_t*> layerData;
+            for (auto i(0u); i < layers.size(); i++)
+            {
+                const auto source(m_Tilemap.getLayer(i));
+                layers[i].resize(static_cast<std::size_t>(m_MapWidth) * m_MapHeight);
+                for (auto y(0u); y < m_MapHeight; y++)
+                    for (auto x(0u); x < m_MapWidth; x++)
+                        layers[i][static_cast<std::size_t>(y) * m_MapWidth + x] = source[get1DIndexFrom2D(x % width, y % height, width)];
+                layerData.emplace_back(layers[i].data());
+            }
+            m_Tilemap.load(layerData.data(), m_Tilemap.getLayerCount(), m_MapWidth, m_MapHeight, &m_Game.getJobs());
+        }
+
+        if (loaded && !m_ExportPath.empty() && !m_Tilemap.saveToFile(m_ExportPath))
+            std::cerr << "Tilemap: couldn't write " << m_ExportPath << std::endl;
+
+        // The walls of the ground layer block the ray to the cursor
+        std::vector<bool> solidIds(lastWallTile + 1u, false);
+        for (auto id(firstWallTile); id <= lastWallTile; id++) solidIds[id] = true;
+        m_Tilemap.setCollision(0, std::move(solidIds));
+
+        m_Tilemap.setVertexBuffers(m_VertexBuffers);
     }
 
     inline void onUpdate(float ft)
@@ -73,22 +157,119 @@ private:
 
     }
 
+    // Left click places a wall tile, right click clears the area around the cursor, decorations included
+    inline void onClick(const sf::Event::MouseButtonEvent& click)
+    {
+        const auto pos(m_Game.getWindow().mapPixelToCoords({click.x, click.y}, m_Camera));
+        if (m_Streaming || pos.x < 0.f || pos.y < 0.f) return;
+
+        const auto tileSize(m_Tilemap.getTileSize());
+        const auto x(static_cast<unsigned int>(pos.x) / tileSize.x), y(static_cast<unsigned int>(pos.y) / tileSize.y);
+        if (x >= m_Tilemap.getWidth() || y >= m_Tilemap.getHeight()) return;
+
+        if (click.button == sf::Mouse::Left) m_Tilemap.setTile(x, y, 2);
+        else if (click.button == sf::Mouse::Right)
+        {
+            const auto left(x > blastSize / 2 ? x - blastSize / 2 : 0), top(y > blastSize / 2 ? y - blastSize / 2 : 0);
+            const auto width(std::min(blastSize, m_Tilemap.getWidth() - left)), height(std::min(blastSize, m_Tilemap.getHeight() - top));
+            m_Tilemap.fillTiles(left, top, width, height, 0, 0, &m_Game.getJobs());
+            for (auto layer(1u); layer < m_Tilemap.getLayerCount(); layer++)
+                m_Tilemap.fillTiles(left, top, width, height, emptyTile, layer, &m_Game.getJobs());
+        }
+    }
+
+    // Arrow keys or WASD scroll the map. Headless runs have no input devices to poll (SFML may not even reach a
+    // display), so only --fly moves the camera there and the ray to the cursor is skipped.
+    inline void onUpdateVariable(float dt)
+    {
+        Vec2f direction;
+        if (m_Flying) direction = {1.f, .5f};
+        else if (!m_Game.isHeadless())
+        {
+            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Left) || sf::Keyboard::isKeyPressed(sf::Keyboard::A)) direction.x -= 1.f;
+            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Right) || sf::Keyboard::isKeyPressed(sf::Keyboard::D)) direction.x += 1.f;
+            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Up) || sf::Keyboard::isKeyPressed(sf::Keyboard::W)) direction.y -= 1.f;
+            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Down) || sf::Keyboard::isKeyPressed(sf::Keyboard::S)) direction.y += 1.f;
+        }
+
+        m_CameraVelocity = direction * cameraSpeed;
+        m_Camera.move(m_CameraVelocity * dt);
+        if (m_Streaming) m_Stream.update(m_Camera, m_CameraVelocity);
+        else if (!m_Game.isHeadless()) updateRay();
+    }
+
+    // Line of sight from the center of the view to the cursor, cut short at the first wall
+    inline void updateRay()
+    {
+        const auto& window(m_Game.getWindow());
+        const auto origin(m_Camera.getCenter()), target(window.mapPixelToCoords(sf::Mouse::getPosition(window), m_Camera));
+        const auto toTarget(target - origin);
+        const auto hit(m_Tilemap.getCollision().raycast(origin, toTarget, std::hypot(toTarget.x, toTarget.y)));
+
+        const auto color(hit.hit ? sf::Color::Red : sf::Color::Green);
+        m_Ray[0] = {origin, color};
+        m_Ray[1] = {hit.hit ? hit.point : target, color};
+    }
+
     inline void onDraw(sf::RenderTarget& target)
-    {        
-        target.draw(m_Tilemap);
+    {
+        target.setView(m_Camera);
+        if (m_Streaming) target.draw(m_Stream);
+        else
+        {
+            target.draw(m_Tilemap);
+            target.draw(m_Ray);
+        }
+        target.setView(target.getDefaultView());
         target.draw(m_FpsText);
     }
 
 private:
     Game m_Game{"Tilemap"};
     Tilemap m_Tilemap;
-    sf::Font m_Sansation;
+    StreamingTilemap m_Stream;
+    FontHandle m_Sansation;
     sf::Text m_FpsText;
+    sf::View m_Camera;
+    sf::VertexArray m_Ray{sf::Lines, 2};
+    Vec2f m_CameraVelocity;
+    bool m_ShowProfile{false}, m_VertexBuffers{true}, m_Streaming{false}, m_Flying{false};
+    unsigned int m_MapWidth{0}, m_MapHeight{0};
+    std::string m_MapPath{"Assets/level.tmap"}, m_ExportPath;
 };
 
-int main()
+// Usage: Tilemap [--map-file PATH] [--map WIDTH HEIGHT] [--write-map PATH] [--vertex-arrays] [--stream [CACHE_CHUNKS]] [--fly] plus the GameBase flags (see GameBase::runFromArgs)
+int main(int argc, char* argv[])
 {
     TilemapGame game;
-    game.run();
-    return 0;
+    auto streaming(false), edited(false);
+    for (auto i(1); i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--vertex-arrays") == 0) game.setVertexBuffers(false);
+        else if (std::strcmp(argv[i], "--fly") == 0) game.setFlying(true);
+        else if (std::strcmp(argv[i], "--stream") == 0)
+        {
+            streaming = true;
+            game.setStreaming(i + 1 < argc && std::isdigit(static_cast<unsigned char>(argv[i + 1][0])) ? std::strtoul(argv[i + 1], nullptr, 10) : 1024);
+        }
+        else if (std::strcmp(argv[i], "--map-file") == 0 && i + 1 < argc) game.setMapPath(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--write-map") == 0 && i + 1 < argc)
+        {
+            edited = true;
+            game.setExportPath(argv[i + 1]);
+        }
+        else if (std::strcmp(argv[i], "--map") == 0 && i + 2 < argc)
+        {
+            edited = true;
+            game.setMapSize(std::strtoul(argv[i + 1], nullptr, 10), std::strtoul(argv[i + 2], nullptr, 10));
+        }
+    }
+
+    // The streamed file is drawn as it is; write the resized map first and stream that
+    if (streaming && edited)
+    {
+        std::cerr << "Tilemap: --stream can't be combined with --map or --write-map" << std::endl;
+        return 1;
+    }
+    return game.run(argc, argv);
 }
\ No newline at end of file
@@ -0,0 +1,100 @@
+#pragma once
+#include "../Common/Common.hpp"
+#include "../Common/MappedFile.hpp"
+
+// Binary tile map (.tmap), used in place from a memory mapping without a parsing step:
+//
+//     MapFileHeader
+//     uvCount x MapTileUv                          at uvOffset
+//     layerCount x height x width x u16 tile id     at layerOffset, layer by layer, rows top to bottom
+//
+// A tile id indexes the UV table, which names the tileset cell the tile is drawn with; emptyTile leaves the
+// cell empty (and so do ids past the end of the table). Layers are drawn in order, so later ones go on top.
+// All values are little-endian, like every platform this builds on, and every section is naturally aligned.
+
+constexpr std::uint16_t emptyTile{0xFFFF};
+constexpr std::uint32_t mapFileVersion{1};
+constexpr std::uint32_t maxMapLayers{256};
+
+struct MapFileHeader
+{
+    char magic[4];                              // "TMAP"
+    std::uint32_t version;
+    std::uint32_t width, height, layerCount;    // In tiles
+    std::uint32_t tileWidth, tileHeight;        // Tile size in pixels, in the tileset and in the world
+    std::uint32_t uvCount;
+    std::uint64_t uvOffset, layerOffset;        // In bytes from the start of the file
+};
+
+// Tileset cell of a tile id, in tiles
+struct MapTileUv
+{
+    std::uint16_t column, row;
+};
+
+static_assert(sizeof(MapFileHeader) == 48 && sizeof(MapTileUv) == 4, "The map file layout must not contain padding");
+
+class MapFile
+{
+public:
+    // Maps the file and checks the header and that every section lies within the file. The checks are written
+    // so a crafted header can't make them wrap around.
+    inline bool open(const std::string& path)
+    {
+        m_Header = nullptr;
+        if (!m_File.open(path) || m_File.getSize() < sizeof(MapFileHeader)) return false;
+
+        const auto header(reinterpret_cast<const MapFileHeader*>(m_File.getData()));
+        if (std::memcmp(header->magic, "TMAP", 4) != 0 || header->version != mapFileVersion) return false;
+
+        const auto size(static_cast<std::uint64_t>(m_File.getSize()));
+        if (header->layerCount > maxMapLayers || header->uvOffset % alignof(MapTileUv) != 0 || header->layerOffset % alignof(std::uint16_t) != 0
+            || header->uvOffset > size || header->layerOffset > size) return false;
+
+        // Both factors of each product are 32 bits wide, so they fit in 64
+        const auto uvBytes(static_cast<std::uint64_t>(header->uvCount) * sizeof(MapTileUv));
+        const auto layerTiles(static_cast<std::uint64_t>(header->width) * header->height);
+        const auto tilesLeft((size - header->layerOffset) / sizeof(std::uint16_t));
+        if (uvBytes > size - header->uvOffset || (header->layerCount != 0 && layerTiles > tilesLeft / header->layerCount)) return false;
+
+        m_Header = header;
+        return true;
+    }
+
+    inline bool isOpen() const noexcept { return m_Header != nullptr; }
+    inline const MapFileHeader& getHeader() const noexcept { return *m_Header; }
+
+    inline const MapTileUv* getUvs() const noexcept
+    {
+        return reinterpret_cast<const MapTileUv*>(m_File.getData() + m_Header->uvOffset);
+    }
+
+    // width * height tile ids
+    inline const std::uint16_t* getLayer(std::size_t layer) const noexcept
+    {
+        const auto layerSize(static_cast<std::size_t>(m_Header->width) * m_Header->height);
+        return reinterpret_cast<const std::uint16_t*>(m_File.getData() + m_Header->layerOffset) + layer * layerSize;
+    }
+
+private:
+    MappedFile m_File;
+    const MapFileHeader* m_Header{nullptr};
+};
+
+// Writes a map; `layers` holds the width * height tile ids of every layer
+inline bool writeMapFile(const std::string& path, unsigned int width, unsigned int height, Vec2u tileSize,
+    const std::vector<MapTileUv>& uvs, const std::vector<const std::uint16_t*>& layers)
+{
+    MapFileHeader header{{'T', 'M', 'A', 'P'}, mapFileVersion, width, height, static_cast<std::uint32_t>(layers.size()),
+        tileSize.x, tileSize.y, static_cast<std::uint32_t>(uvs.size()), sizeof(MapFileHeader), 0};
+    header.layerOffset = header.uvOffset + uvs.size() * sizeof(MapTileUv);
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file) return false;
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(uvs.data()), static_cast<std::streamsize>(uvs.size() * sizeof(MapTileUv)));
+    for (const auto layer : layers)
+        file.write(reinterpret_cast<const char*>(layer), static_cast<std::streamsize>(static_cast<std::size_t>(width) * height * sizeof(std::uint16_t)));
+    return static_cast<bool>(file);
+}
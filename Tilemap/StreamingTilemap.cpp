@@ -0,0 +1,278 @@
+#include "StreamingTilemap.hpp"
+
+StreamingTilemap::~StreamingTilemap()
+{
+    stop();
+}
+
+void StreamingTilemap::stop()
+{
+    if (!m_Loader.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock{m_Mutex};
+        m_Quit = true;
+    }
+    m_Cv.notify_all();
+    m_Loader.join();
+}
+
+bool StreamingTilemap::open(const std::string& path)
+{
+    // The loader reads the mapping, so it has to be gone before the file changes
+    stop();
+
+    m_Resident.clear();
+    m_Lru.clear();
+    m_RequestTimes.clear();
+    m_Requests.clear();
+    m_Finished.clear();
+    m_Loading = noChunk;
+    m_Quit = false;
+    m_Queued = m_MemoryUsage = m_StalledChunks = m_StallCount = m_LoadedChunks = m_EvictedChunks = m_LatencyCount = 0;
+    m_LatencySum = m_MaxLatency = 0.0;
+
+    if (!m_File.open(path))
+    {
+        std::cerr << "StreamingTilemap: " << path << " is not a valid map file" << std::endl;
+        return false;
+    }
+
+    const auto& header(m_File.getHeader());
+    m_Uvs.assign(m_File.getUvs(), m_File.getUvs() + header.uvCount);
+    m_TileSize = {header.tileWidth, header.tileHeight};
+    m_Width = header.width;
+    m_Height = header.height;
+    m_LayerCount = header.layerCount;
+    m_ChunksX = (m_Width + chunkSize - 1) / chunkSize;
+    m_ChunksY = (m_Height + chunkSize - 1) / chunkSize;
+
+    m_Loader = std::thread{[this]() { loaderMain(); }};
+    return true;
+}
+
+void StreamingTilemap::loaderMain()
+{
+    Tracer::get().setThreadName("tile streamer");
+
+    std::unique_lock<std::mutex> lock{m_Mutex};
+    while (true)
+    {
+        m_Cv.wait(lock, [this]() { return !m_Requests.empty() || m_Quit; });
+        if (m_Quit) return;
+
+        m_Loading = m_Requests.front();
+        m_Requests.pop_front();
+        lock.unlock();
+
+        FinishedChunk chunk{m_Loading, buildChunk(m_Loading)};
+
+        lock.lock();
+        m_Finished.emplace_back(std::move(chunk));
+        m_Loading = noChunk;
+    }
+}
+
+std::vector<sf::Vertex> StreamingTilemap::buildChunk(ChunkKey key) const
+{
+    TRACE_SCOPE("StreamingTilemap::buildChunk");
+
+    const auto chunksPerLayer(static_cast<ChunkKey>(m_ChunksX) * m_ChunksY);
+    const auto layer(static_cast<unsigned int>(key / chunksPerLayer));
+    const auto chunkX(static_cast<unsigned int>(key % chunksPerLayer % m_ChunksX)), chunkY(static_cast<unsigned int>(key % chunksPerLayer / m_ChunksX));
+    const auto firstX(chunkX * chunkSize), lastX(std::min(firstX + chunkSize, m_Width));
+    const auto firstY(chunkY * chunkSize), lastY(std::min(firstY + chunkSize, m_Height));
+
+    // Touching the tiles is what pages them in from the file
+    const auto tiles(m_File.getLayer(layer));
+    std::size_t visibleTiles{0};
+    for (auto y(firstY); y < lastY; y++)
+        for (auto x(firstX); x < lastX; x++) visibleTiles += tiles[static_cast<std::size_t>(y) * m_Width + x] < m_Uvs.size();
+
+    // Read-only chunks can leave empty tiles out instead of keeping a quad for them
+    std::vector<sf::Vertex> vertices(visibleTiles * 4);
+    auto quad(vertices.data());
+    for (auto y(firstY); y < lastY; y++)
+    {
+        for (auto x(firstX); x < lastX; x++)
+        {
+            const auto tile(tiles[static_cast<std::size_t>(y) * m_Width + x]);
+            if (tile >= m_Uvs.size()) continue;
+            setTileQuad(quad, x, y, tile, m_TileSize, m_Uvs);
+            quad += 4;
+        }
+    }
+    return vertices;
+}
+
+void StreamingTilemap::update(const sf::View& view, Vec2f velocity)
+{
+    TRACE_SCOPE("StreamingTilemap::update");
+    if (!m_Loader.joinable()) return;
+    m_Update++;
+
+    auto loading(noChunk);
+    {
+        std::lock_guard<std::mutex> lock{m_Mutex};
+        std::swap(m_Arrived, m_Finished);
+        loading = m_Loading;
+    }
+
+    const auto now(HRClock::now());
+    for (auto& chunk : m_Arrived)
+    {
+        const auto requested(m_RequestTimes.find(chunk.key));
+        if (requested != m_RequestTimes.end())
+        {
+            const auto latency(std::chrono::duration<double, std::milli>(now - requested->second).count());
+            m_LatencySum += latency;
+            m_MaxLatency = std::max(m_MaxLatency, latency);
+            m_LatencyCount++;
+            m_RequestTimes.erase(requested);
+        }
+
+        m_LoadedChunks++;
+        if (m_Resident.count(chunk.key) != 0) continue;
+
+        m_Lru.emplace_front(chunk.key);
+        m_MemoryUsage += chunk.vertices.size() * sizeof(sf::Vertex);
+        m_Resident.emplace(chunk.key, ResidentChunk{std::move(chunk.vertices), m_Lru.begin(), 0});
+    }
+    m_Arrived.clear();
+
+    // Visible chunks, then the prefetch area: the visible range grown by the radius and stretched by the
+    // distance the camera covers within the lookahead
+    const auto visible(getVisibleChunks(view, getTransform()));
+    const auto chunkWidth(static_cast<float>(chunkSize * m_TileSize.x)), chunkHeight(static_cast<float>(chunkSize * m_TileSize.y));
+    const auto ahead(Vec2f{velocity.x / chunkWidth, velocity.y / chunkHeight} * m_Lookahead);
+    const auto grow([](unsigned int first, unsigned int last, float ahead, unsigned int radius, unsigned int count, unsigned int& outFirst, unsigned int& outLast)
+    {
+        const auto behind(static_cast<float>(radius) + std::max(-ahead, 0.f)), front(static_cast<float>(radius) + std::max(ahead, 0.f));
+        outFirst = static_cast<unsigned int>(std::max(static_cast<float>(first) - std::ceil(behind), 0.f));
+        outLast = static_cast<unsigned int>(std::min(static_cast<float>(last) + std::ceil(front), static_cast<float>(count)));
+    });
+    ChunkRect prefetch;
+    grow(visible.firstX, visible.lastX, ahead.x, m_PrefetchRadius, m_ChunksX, prefetch.firstX, prefetch.lastX);
+    grow(visible.firstY, visible.lastY, ahead.y, m_PrefetchRadius, m_ChunksY, prefetch.firstY, prefetch.lastY);
+
+    // Nearest to where the camera is headed first
+    const auto centerX((visible.firstX + visible.lastX) * .5f + ahead.x), centerY((visible.firstY + visible.lastY) * .5f + ahead.y);
+    std::vector<Vec2u> area;
+    for (auto cy(prefetch.firstY); cy < prefetch.lastY; cy++)
+        for (auto cx(prefetch.firstX); cx < prefetch.lastX; cx++) area.emplace_back(cx, cy);
+    std::sort(area.begin(), area.end(), [centerX, centerY](const Vec2u& a, const Vec2u& b)
+    {
+        const auto distance([centerX, centerY](const Vec2u& c)
+        {
+            const auto dx(c.x + .5f - centerX), dy(c.y + .5f - centerY);
+            return dx * dx + dy * dy;
+        });
+        return distance(a) < distance(b);
+    });
+    const auto isVisible([&visible](const Vec2u& c)
+    {
+        return c.x >= visible.firstX && c.x < visible.lastX && c.y >= visible.firstY && c.y < visible.lastY;
+    });
+    std::stable_partition(area.begin(), area.end(), isVisible);
+
+    // Prefetching stops where the cache would have to evict chunks still in the area
+    const auto visibleChunks((visible.lastX - visible.firstX) * (visible.lastY - visible.firstY) * static_cast<std::size_t>(m_LayerCount));
+    const auto budget(std::max(m_CacheCapacity, visibleChunks));
+
+    m_Wanted.clear();
+    m_StalledChunks = 0;
+    std::size_t considered{0}, touched{0};
+    for (const auto& c : area)
+    {
+        const auto inView(isVisible(c));
+        for (auto layer(0u); layer < m_LayerCount && (inView || considered < budget); layer++, considered++)
+        {
+            const auto key(getKey(layer, c.x, c.y));
+            const auto resident(m_Resident.find(key));
+            if (resident == m_Resident.end())
+            {
+                if (inView) m_StalledChunks++;
+                if (key != loading) m_Wanted.emplace_back(key);
+                continue;
+            }
+
+            // Further away means less recently used, so the LRU order follows the priority order
+            m_Lru.splice(m_Lru.end(), m_Lru, resident->second.lru);
+            touched++;
+            if (inView) resident->second.visibleUpdate = m_Update;
+        }
+    }
+    m_StallCount += m_StalledChunks;
+
+    // Everything touched this update moved to the back in priority order; rotating it to the front leaves
+    // the untouched (oldest) chunks at the back, where eviction starts
+    auto firstTouched(m_Lru.end());
+    for (std::size_t i(0); i < touched; i++) --firstTouched;
+    if (firstTouched != m_Lru.begin()) m_Lru.splice(m_Lru.begin(), m_Lru, firstTouched, m_Lru.end());
+
+    // Only chunks that are still wanted keep their request time
+    std::unordered_map<ChunkKey, HRClock::time_point> requestTimes;
+    for (const auto key : m_Wanted)
+    {
+        const auto requested(m_RequestTimes.find(key));
+        requestTimes.emplace(key, requested != m_RequestTimes.end() ? requested->second : now);
+    }
+    if (loading != noChunk && m_RequestTimes.count(loading) != 0) requestTimes.emplace(loading, m_RequestTimes[loading]);
+    m_RequestTimes = std::move(requestTimes);
+
+    // The queue is replaced as a whole, so chunks the camera left behind are dropped before they're built
+    {
+        std::lock_guard<std::mutex> lock{m_Mutex};
+        m_Requests.assign(m_Wanted.begin(), m_Wanted.end());
+    }
+    m_Cv.notify_one();
+    m_Queued = m_Wanted.size();
+
+    while (m_Resident.size() > m_CacheCapacity)
+    {
+        const auto oldest(m_Resident.find(m_Lru.back()));
+        if (oldest->second.visibleUpdate == m_Update) break;
+
+        m_MemoryUsage -= oldest->second.vertices.size() * sizeof(sf::Vertex);
+        m_Resident.erase(oldest);
+        m_Lru.pop_back();
+        m_EvictedChunks++;
+    }
+}
+
+StreamingTilemap::ChunkRect StreamingTilemap::getVisibleChunks(const sf::View& view, const sf::Transform& transform) const
+{
+    const auto visible(transform.getInverse().transformRect(view.getInverseTransform().transformRect({-1.f, -1.f, 2.f, 2.f})));
+
+    const auto chunkWidth(static_cast<float>(chunkSize * m_TileSize.x)), chunkHeight(static_cast<float>(chunkSize * m_TileSize.y));
+    const auto clampChunk([](float chunk, unsigned int count)
+    {
+        return static_cast<unsigned int>(std::min(std::max(chunk, 0.f), static_cast<float>(count)));
+    });
+    return {clampChunk(std::floor(visible.left / chunkWidth), m_ChunksX), clampChunk(std::floor(visible.top / chunkHeight), m_ChunksY),
+        clampChunk(std::ceil((visible.left + visible.width) / chunkWidth), m_ChunksX),
+        clampChunk(std::ceil((visible.top + visible.height) / chunkHeight), m_ChunksY)};
+}
+
+void StreamingTilemap::draw(sf::RenderTarget& target, sf::RenderStates states) const
+{
+    TRACE_SCOPE("StreamingTilemap::draw");
+    if (!m_Tileset.isReady()) return;
+    states.transform *= getTransform();
+    states.texture = &m_Tileset.get();
+
+    const auto visible(getVisibleChunks(target.getView(), states.transform));
+    m_DrawnChunks = 0;
+    for (auto layer(0u); layer < m_LayerCount; layer++)
+    {
+        for (auto cy(visible.firstY); cy < visible.lastY; cy++)
+        {
+            for (auto cx(visible.firstX); cx < visible.lastX; cx++)
+            {
+                const auto chunk(m_Resident.find(getKey(layer, cx, cy)));
+                if (chunk == m_Resident.end() || chunk->second.vertices.empty()) continue;
+                target.draw(chunk->second.vertices.data(), chunk->second.vertices.size(), sf::Quads, states);
+                m_DrawnChunks++;
+            }
+        }
+    }
+}
@@ -0,0 +1,128 @@
+#pragma once
+#include "Tilemap.hpp"
+#include <list>
+#include <unordered_map>
+
+// Read-only tilemap that streams its chunks out of a memory-mapped .tmap file, for maps too large to keep
+// in memory as vertices. update() hands a background loader thread the chunks it's missing around the
+// camera: first the visible ones, then those within the prefetch area, which stretches ahead in the direction
+// the camera moves. The loader reads the tiles from the mapping and builds the vertices; the main thread only
+// swaps finished chunks into a bounded LRU cache and draws the resident ones. A visible chunk that isn't
+// resident yet is a stall: it stays blank until the loader delivers it.
+class StreamingTilemap : public sf::Drawable, public sf::Transformable
+{
+public:
+    inline StreamingTilemap() = default;
+    ~StreamingTilemap();
+
+    StreamingTilemap(const StreamingTilemap&) = delete;
+    StreamingTilemap& operator=(const StreamingTilemap&) = delete;
+
+    // Nothing is drawn until the tileset is ready
+    inline void setTileset(TextureHandle tileset) noexcept { m_Tileset = std::move(tileset); }
+
+    // Maps the file and starts the loader; nothing is loaded before the first update()
+    bool open(const std::string& path);
+
+    // Swaps in the chunks finished since the last call, queues the missing ones around `view` and evicts the
+    // least recently used ones beyond the cache capacity. `velocity` is the camera's, in pixels per second.
+    void update(const sf::View& view, Vec2f velocity);
+
+    // Resident chunks, every layer's counted separately. Chunks in view are never evicted, so the cache
+    // outgrows the capacity if the view alone covers more; prefetching is limited to what's left over.
+    inline void setCacheCapacity(std::size_t chunks) noexcept { m_CacheCapacity = chunks; }
+    inline std::size_t getCacheCapacity() const noexcept { return m_CacheCapacity; }
+
+    // Chunks prefetched on every side of the view, plus `lookahead` seconds of camera movement
+    inline void setPrefetch(unsigned int radius, float lookahead) noexcept
+    {
+        m_PrefetchRadius = radius;
+        m_Lookahead = lookahead;
+    }
+
+    inline unsigned int getWidth() const noexcept { return m_Width; }
+    inline unsigned int getHeight() const noexcept { return m_Height; }
+    inline unsigned int getLayerCount() const noexcept { return m_LayerCount; }
+    inline Vec2u getTileSize() const noexcept { return m_TileSize; }
+
+    inline std::size_t getResidentChunkCount() const noexcept { return m_Resident.size(); }
+    inline std::size_t getQueuedChunkCount() const noexcept { return m_Queued; }
+    inline std::size_t getDrawnChunkCount() const noexcept { return m_DrawnChunks; }
+    inline std::size_t getMemoryUsage() const noexcept { return m_MemoryUsage; }
+
+    // Visible chunks missing in the last update, and their total over all updates
+    inline std::size_t getStalledChunkCount() const noexcept { return m_StalledChunks; }
+    inline std::size_t getStallCount() const noexcept { return m_StallCount; }
+
+    // Totals since open()
+    inline std::size_t getLoadedChunkCount() const noexcept { return m_LoadedChunks; }
+    inline std::size_t getEvictedChunkCount() const noexcept { return m_EvictedChunks; }
+
+    // Milliseconds from a chunk's first request to its swap-in
+    inline double getAverageLoadLatency() const noexcept { return m_LatencyCount > 0 ? m_LatencySum / m_LatencyCount : 0.0; }
+    inline double getMaxLoadLatency() const noexcept { return m_MaxLatency; }
+
+private:
+    using ChunkKey = std::uint64_t;
+    static constexpr ChunkKey noChunk{std::numeric_limits<ChunkKey>::max()};
+
+    struct ChunkRect
+    {
+        unsigned int firstX, firstY, lastX, lastY;
+    };
+
+    struct ResidentChunk
+    {
+        std::vector<sf::Vertex> vertices;   // Only the non-empty tiles
+        std::list<ChunkKey>::iterator lru;
+        std::size_t visibleUpdate{0};       // Last update that saw the chunk in view
+    };
+
+    struct FinishedChunk
+    {
+        ChunkKey key;
+        std::vector<sf::Vertex> vertices;
+    };
+
+    inline ChunkKey getKey(unsigned int layer, unsigned int chunkX, unsigned int chunkY) const noexcept
+    {
+        return (static_cast<ChunkKey>(layer) * m_ChunksY + chunkY) * m_ChunksX + chunkX;
+    }
+
+    void stop();
+    void loaderMain();
+    std::vector<sf::Vertex> buildChunk(ChunkKey key) const;
+
+    ChunkRect getVisibleChunks(const sf::View& view, const sf::Transform& transform) const;
+    void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+
+private:
+    MapFile m_File;
+    TextureHandle m_Tileset;
+    std::vector<MapTileUv> m_Uvs;
+    Vec2u m_TileSize{tileWidth, tileHeight};
+    unsigned int m_Width{0}, m_Height{0}, m_LayerCount{0}, m_ChunksX{0}, m_ChunksY{0};
+
+    // Main thread only
+    std::unordered_map<ChunkKey, ResidentChunk> m_Resident;
+    std::list<ChunkKey> m_Lru;                                      // Most recently used first
+    std::unordered_map<ChunkKey, HRClock::time_point> m_RequestTimes;
+    std::vector<FinishedChunk> m_Arrived;
+    std::vector<ChunkKey> m_Wanted;
+    std::size_t m_CacheCapacity{1024};
+    unsigned int m_PrefetchRadius{1};
+    float m_Lookahead{.5f};
+    std::size_t m_Update{0}, m_Queued{0}, m_MemoryUsage{0};
+    std::size_t m_StalledChunks{0}, m_StallCount{0}, m_LoadedChunks{0}, m_EvictedChunks{0}, m_LatencyCount{0};
+    double m_LatencySum{0.0}, m_MaxLatency{0.0};
+    mutable std::size_t m_DrawnChunks{0};
+
+    // Shared with the loader, guarded by m_Mutex
+    std::mutex m_Mutex;
+    std::condition_variable m_Cv;
+    std::deque<ChunkKey> m_Requests;
+    std::vector<FinishedChunk> m_Finished;
+    ChunkKey m_Loading{noChunk};
+    bool m_Quit{false};
+    std::thread m_Loader;
+};
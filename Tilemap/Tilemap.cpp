@@ -1,106 +1,262 @@
 #include "Tilemap.hpp"
 #include <iostream>
 
-bool Tilemap::load(const int* data, unsigned int width, unsigned int height)
+bool Tilemap::loadFromFile(const std::string& path, JobSystem* jobs)
 {
-    if (!m_Tileset.loadFromFile("Assets/tileset.png"))
+    MapFile file;
+    if (!file.open(path))
+    {
+        std::cerr << "Tilemap: " << path << " is not a valid map file" << std::endl;
         return false;
+    }
+
+    // The sections are used as they are in the mapping, the tiles are only copied so they can be edited
+    const auto& header(file.getHeader());
+    m_Uvs.assign(file.getUvs(), file.getUvs() + header.uvCount);
+    m_TileSize = {header.tileWidth, header.tileHeight};
+
+    std::vector<const std::uint16_t*> layers(header.layerCount);
+    for (auto i(0u); i < header.layerCount; i++) layers[i] = file.getLayer(i);
+    load(layers.data(), header.layerCount, header.width, header.height, jobs);
+    return true;
+}
+
+bool Tilemap::saveToFile(const std::string& path) const
+{
+    std::vector<const std::uint16_t*> layers;
+    for (const auto& layer : m_Layers) layers.emplace_back(layer.data());
+    return writeMapFile(path, m_Width, m_Height, m_TileSize, m_Uvs, layers);
+}
+
+void Tilemap::load(const std::uint16_t* const* layers, unsigned int layerCount, unsigned int width, unsigned int height, JobSystem* jobs)
+{
+    m_Width = width;
+    m_Height = height;
+    const auto layerSize(static_cast<std::size_t>(width) * height);
+    m_Layers.resize(layerCount);
+    for (auto i(0u); i < layerCount; i++) m_Layers[i].assign(layers[i], layers[i] + layerSize);
 
-    static constexpr float tileWidthF(tileWidth), tileHeightF(tileHeight);
+    m_ChunksX = (width + chunkSize - 1) / chunkSize;
+    m_ChunksY = (height + chunkSize - 1) / chunkSize;
+    m_Chunks.clear();
+    m_Chunks.resize(static_cast<std::size_t>(m_ChunksX) * m_ChunksY * layerCount);
+    rebuildAllChunks(jobs);
+    rebuildCollision();
+}
+
+void Tilemap::setTileUvs(std::vector<MapTileUv> uvs, Vec2u tileSize, JobSystem* jobs)
+{
+    m_Uvs = std::move(uvs);
+    m_TileSize = tileSize;
+    rebuildAllChunks(jobs);
+    rebuildCollision();
+}
+
+void Tilemap::setCollision(unsigned int layer, std::vector<bool> solidIds)
+{
+    m_CollisionLayer = layer;
+    m_SolidIds = std::move(solidIds);
+    rebuildCollision();
+}
+
+void Tilemap::rebuildCollision()
+{
+    const Vec2f tileSize(m_TileSize);
+    if (m_CollisionLayer >= m_Layers.size()) m_Collision.reset(m_Width, m_Height, tileSize);
+    else m_Collision.build(m_Layers[m_CollisionLayer].data(), m_Width, m_Height, tileSize, [this](std::uint16_t tile) { return isSolid(tile); });
+}
 
-    // Init tilemap
-    m_Vertices.resize(width*height*4);
-    for (auto x(0); x < width; x++)
+void Tilemap::setTile(unsigned int x, unsigned int y, std::uint16_t tile, unsigned int layer)
+{
+    assert(x < m_Width && y < m_Height && layer < m_Layers.size());
+    auto& stored(m_Layers[layer][static_cast<std::size_t>(y) * m_Width + x]);
+    const auto previous(stored);
+    stored = tile;
+    if (layer == m_CollisionLayer) m_Collision.setSolid(x, y, isSolid(tile));
+
+    // Only the tile's own quad changes
+    const auto chunkX(x / chunkSize), chunkY(y / chunkSize);
+    const auto rowLength(std::min((chunkX + 1) * chunkSize, m_Width) - chunkX * chunkSize);
+    auto& chunk(getChunk(layer, chunkX, chunkY));
+    const auto quad((y % chunkSize) * rowLength + x % chunkSize);
+    setTileQuad(&chunk.vertices[quad * 4], x, y, tile, m_TileSize, m_Uvs);
+    chunk.visibleTiles += static_cast<std::size_t>(tile < m_Uvs.size()) - static_cast<std::size_t>(previous < m_Uvs.size());
+
+#ifdef TILEMAP_VERTEX_BUFFER
+    if (chunk.uploaded) chunk.patchedQuads.emplace_back(quad);
+#endif
+}
+
+template <typename TGetTile>
+void Tilemap::editRegion(unsigned int left, unsigned int top, unsigned int width, unsigned int height, unsigned int layer, TGetTile&& getTile,
+    JobSystem* jobs)
+{
+    assert(left + width <= m_Width && top + height <= m_Height && layer < m_Layers.size());
+    if (width == 0 || height == 0) return;
+
+    auto& tiles(m_Layers[layer]);
+    for (auto y(0u); y < height; y++)
+        for (auto x(0u); x < width; x++) tiles[static_cast<std::size_t>(top + y) * m_Width + left + x] = getTile(x, y);
+
+    if (layer == m_CollisionLayer)
+        for (auto y(top); y < top + height; y++)
+            for (auto x(left); x < left + width; x++) m_Collision.setSolid(x, y, isSolid(tiles[static_cast<std::size_t>(y) * m_Width + x]));
+
+    for (auto cy(top / chunkSize); cy <= (top + height - 1) / chunkSize; cy++)
+        for (auto cx(left / chunkSize); cx <= (left + width - 1) / chunkSize; cx++) getChunk(layer, cx, cy).dirty = true;
+
+    rebuildDirtyChunks(jobs);
+}
+
+void Tilemap::setTiles(unsigned int left, unsigned int top, unsigned int width, unsigned int height, const std::uint16_t* tiles,
+    unsigned int layer, JobSystem* jobs)
+{
+    editRegion(left, top, width, height, layer, [tiles, width](unsigned int x, unsigned int y)
     {
-        for (auto y(0); y < height; y++)
-        {
-            const auto tileIdx(get1DIndexFrom2D(x, y, width));
+        return tiles[static_cast<std::size_t>(y) * width + x];
+    }, jobs);
+}
+
+void Tilemap::fillTiles(unsigned int left, unsigned int top, unsigned int width, unsigned int height, std::uint16_t tile,
+    unsigned int layer, JobSystem* jobs)
+{
+    editRegion(left, top, width, height, layer, [tile](unsigned int, unsigned int) { return tile; }, jobs);
+}
+
+void Tilemap::setVertexBuffers(bool enabled)
+{
+#ifdef TILEMAP_VERTEX_BUFFER
+    m_UseVertexBuffers = enabled && sf::VertexBuffer::isAvailable();
+#else
+    (void)enabled;
+    m_UseVertexBuffers = false;
+#endif
+}
 
-            auto& nw(m_Vertices[tileIdx*4 + 0]);
-            auto& ne(m_Vertices[tileIdx*4 + 1]);
-            auto& se(m_Vertices[tileIdx*4 + 2]);
-            auto& sw(m_Vertices[tileIdx*4 + 3]);
+std::uint16_t Tilemap::getTile(unsigned int x, unsigned int y, unsigned int layer) const
+{
+    assert(x < m_Width && y < m_Height && layer < m_Layers.size());
+    return m_Layers[layer][static_cast<std::size_t>(y) * m_Width + x];
+}
 
-            nw.position = {(x + 0)*tileWidthF, (y + 0)*tileHeightF};
-            ne.position = {(x + 1)*tileWidthF, (y + 0)*tileHeightF};
-            se.position = {(x + 1)*tileWidthF, (y + 1)*tileHeightF};
-            sw.position = {(x + 0)*tileWidthF, (y + 1)*tileHeightF};
+void Tilemap::rebuildAllChunks(JobSystem* jobs)
+{
+    for (auto& chunk : m_Chunks) chunk.dirty = true;
+    rebuildDirtyChunks(jobs);
+}
 
-            // Calculate texture coordinate
+void Tilemap::rebuildDirtyChunks(JobSystem* jobs)
+{
+    const auto buildChunks([this](std::size_t first, std::size_t last)
+    {
+        for (auto i(first); i < last; i++)
+        {
+            if (!m_Chunks[i].dirty) continue;
+            auto& chunk(m_Chunks[i]);
+            const auto layerChunk(i % (static_cast<std::size_t>(m_ChunksX) * m_ChunksY));
+            buildChunk(chunk, static_cast<unsigned int>(i / (static_cast<std::size_t>(m_ChunksX) * m_ChunksY)),
+                static_cast<unsigned int>(layerChunk % m_ChunksX), static_cast<unsigned int>(layerChunk / m_ChunksX));
+            chunk.dirty = false;
+#ifdef TILEMAP_VERTEX_BUFFER
+            chunk.uploaded = false;
+            chunk.patchedQuads.clear();
+#endif
+        }
+    });
 
-            float tu, tv;
-            switch (data[tileIdx])
-            {
-                case 0:
-                {
-                    tu = 1;
-                    tv = 5;
-                    break;
-                }
-                case 1:
-                {
-                    tu = 0;
-                    tv = 4;
-                    break;
-                }
-                case 2:
-                {
-                    tu = 1;
-                    tv = 4;
-                    break;
-                }
-                case 3:
-                {
-                    tu = 2;
-                    tv = 4;
-                    break;
-                }
-                case 4:
-                {
-                    tu = 2;
-                    tv = 5;
-                    break;
-                }
-                case 5:
-                {
-                    tu = 2;
-                    tv = 6;
-                    break;
-                }
-                case 6:
-                {
-                    tu = 1;
-                    tv = 6;
-                    break;
-                }
-                case 7:
-                {
-                    tu = 0;
-                    tv = 6;
-                    break;
-                }
-                case 8:
-                {
-                    tu = 0;
-                    tv = 5;
-                    break;
-                }
-            }
+    static constexpr std::size_t chunksPerJob{4};
+    if (jobs != nullptr) jobs->parallelFor(0, m_Chunks.size(), chunksPerJob, buildChunks);
+    else buildChunks(0, m_Chunks.size());
+}
 
-            nw.texCoords = {(tu + 0)*tileWidthF, (tv + 0)*tileHeightF};
-            ne.texCoords = {(tu + 1)*tileWidthF, (tv + 0)*tileHeightF};
-            se.texCoords = {(tu + 1)*tileWidthF, (tv + 1)*tileHeightF};
-            sw.texCoords = {(tu + 0)*tileWidthF, (tv + 1)*tileHeightF};
+void Tilemap::buildChunk(Chunk& chunk, unsigned int layer, unsigned int chunkX, unsigned int chunkY)
+{
+    // Chunks on the right and bottom edge may be cut off
+    const auto firstX(chunkX * chunkSize), lastX(std::min(firstX + chunkSize, m_Width));
+    const auto firstY(chunkY * chunkSize), lastY(std::min(firstY + chunkSize, m_Height));
+    chunk.vertices.resize((lastX - firstX) * (lastY - firstY) * 4);
+    chunk.visibleTiles = 0;
 
+    const auto& tiles(m_Layers[layer]);
+    auto quad(chunk.vertices.data());
+    for (auto y(firstY); y < lastY; y++)
+    {
+        for (auto x(firstX); x < lastX; x++, quad += 4)
+        {
+            const auto tile(tiles[static_cast<std::size_t>(y) * m_Width + x]);
+            setTileQuad(quad, x, y, tile, m_TileSize, m_Uvs);
+            if (tile < m_Uvs.size()) chunk.visibleTiles++;
         }
     }
-
-    return true;
 }
 
 void Tilemap::draw(sf::RenderTarget& target, sf::RenderStates states) const
 {
+    TRACE_SCOPE("Tilemap::draw");
+    if (!m_Tileset.isReady()) return;
     states.transform *= getTransform();
-    states.texture = &m_Tileset;
-    target.draw(&m_Vertices[0], m_Vertices.size(), sf::Quads, states);
-}
\ No newline at end of file
+    states.texture = &m_Tileset.get();
+
+    // Visible area in map coordinates: the view's bounds (rotation included) through the inverse transform
+    const auto& view(target.getView());
+    const auto visible(states.transform.getInverse().transformRect(view.getInverseTransform().transformRect({-1.f, -1.f, 2.f, 2.f})));
+
+    const auto chunkWidth(static_cast<float>(chunkSize * m_TileSize.x)), chunkHeight(static_cast<float>(chunkSize * m_TileSize.y));
+    const auto clampChunk([](float chunk, unsigned int count)
+    {
+        return static_cast<unsigned int>(std::min(std::max(chunk, 0.f), static_cast<float>(count)));
+    });
+    const auto firstX(clampChunk(std::floor(visible.left / chunkWidth), m_ChunksX));
+    const auto lastX(clampChunk(std::ceil((visible.left + visible.width) / chunkWidth), m_ChunksX));
+    const auto firstY(clampChunk(std::floor(visible.top / chunkHeight), m_ChunksY));
+    const auto lastY(clampChunk(std::ceil((visible.top + visible.height) / chunkHeight), m_ChunksY));
+
+    m_DrawnChunks = 0;
+    m_UploadedBytes = 0;
+    for (std::size_t layer(0); layer < m_Layers.size(); layer++)
+    {
+        for (auto cy(firstY); cy < lastY; cy++)
+        {
+            for (auto cx(firstX); cx < lastX; cx++)
+            {
+                const auto& chunk(m_Chunks[(layer * m_ChunksY + cy) * m_ChunksX + cx]);
+                if (chunk.visibleTiles == 0) continue;
+                drawChunk(chunk, target, states);
+                m_DrawnChunks++;
+            }
+        }
+    }
+}
+
+void Tilemap::drawChunk(const Chunk& chunk, sf::RenderTarget& target, const sf::RenderStates& states) const
+{
+#ifdef TILEMAP_VERTEX_BUFFER
+    if (m_UseVertexBuffers)
+    {
+        if (!chunk.uploaded && !chunk.uploadFailed)
+        {
+            const auto created(chunk.buffer.getVertexCount() == chunk.vertices.size() || chunk.buffer.create(chunk.vertices.size()));
+            chunk.uploaded = created && chunk.buffer.update(chunk.vertices.data());
+            chunk.uploadFailed = !chunk.uploaded;
+            chunk.patchedQuads.clear();
+            if (chunk.uploaded) m_UploadedBytes += chunk.vertices.size() * sizeof(sf::Vertex);
+        }
+        else if (chunk.uploaded)
+        {
+            for (const auto quad : chunk.patchedQuads) chunk.buffer.update(&chunk.vertices[quad * 4], 4, quad * 4);
+            m_UploadedBytes += chunk.patchedQuads.size() * 4 * sizeof(sf::Vertex);
+            chunk.patchedQuads.clear();
+        }
+
+        // A failed upload isn't retried every frame; the chunk falls through to the client-side path
+        if (chunk.uploaded)
+        {
+            target.draw(chunk.buffer, states);
+            return;
+        }
+    }
+#endif
+
+    target.draw(chunk.vertices.data(), chunk.vertices.size(), sf::Quads, states);
+    m_UploadedBytes += chunk.vertices.size() * sizeof(sf::Vertex);
+}
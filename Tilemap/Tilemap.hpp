@@ -1,18 +1,150 @@
 #pragma once
 #include "../Common/Common.hpp"
+#include "MapFile.hpp"
 #include <vector>
 
+// sf::VertexBuffer exists since SFML 2.5
+#if SFML_VERSION_MAJOR > 2 || (SFML_VERSION_MAJOR == 2 && SFML_VERSION_MINOR >= 5)
+#define TILEMAP_VERTEX_BUFFER
+#endif
+
+// Tile size used until a map file says otherwise
 constexpr unsigned int tileWidth{32}, tileHeight{32};
 
+// Tiles per chunk side
+constexpr unsigned int chunkSize{32};
+
+// Writes the positions and texture coordinates of tile (x, y). Empty tiles (and ids without a UV entry) collapse
+// to a zero-area quad, which keeps every chunk's layout fixed.
+inline void setTileQuad(sf::Vertex* quad, unsigned int x, unsigned int y, std::uint16_t tile, Vec2u tileSize, const std::vector<MapTileUv>& uvs)
+{
+    const auto tw(static_cast<float>(tileSize.x)), th(static_cast<float>(tileSize.y));
+    if (tile >= uvs.size())
+    {
+        for (auto i(0); i < 4; i++) quad[i].position = {x*tw, y*th};
+        return;
+    }
+
+    quad[0].position = {(x + 0)*tw, (y + 0)*th};
+    quad[1].position = {(x + 1)*tw, (y + 0)*th};
+    quad[2].position = {(x + 1)*tw, (y + 1)*th};
+    quad[3].position = {(x + 0)*tw, (y + 1)*th};
+
+    const auto tu(static_cast<float>(uvs[tile].column)), tv(static_cast<float>(uvs[tile].row));
+    quad[0].texCoords = {(tu + 0)*tw, (tv + 0)*th};
+    quad[1].texCoords = {(tu + 1)*tw, (tv + 0)*th};
+    quad[2].texCoords = {(tu + 1)*tw, (tv + 1)*th};
+    quad[3].texCoords = {(tu + 0)*tw, (tv + 1)*th};
+}
+
+// The map is a stack of layers of u16 tile ids, drawn bottom to top; the UV table maps every id to its tileset
+// cell. Each layer is split into chunks of chunkSize x chunkSize tiles with their own vertices; draw() only
+// submits the chunks that intersect the target's current view and contain at least one non-empty tile. With
+// vertex buffers enabled, every chunk's geometry also lives in a static GPU buffer that draw() uploads only when
+// the chunk changed (single-tile edits upload just their quad), so the steady state sends no vertices at all.
 class Tilemap : public sf::Drawable, public sf::Transformable
 {
 public:
-    bool load(const int* data, unsigned int width, unsigned int height);
+    // Nothing is drawn until the tileset is ready
+    inline void setTileset(TextureHandle tileset) noexcept { m_Tileset = std::move(tileset); }
+
+    // Loads a .tmap file (see MapFile.hpp): its layers, UV table and tile size replace the current ones
+    bool loadFromFile(const std::string& path, JobSystem* jobs = nullptr);
+
+    // Writes the current layers, UV table and tile size as a .tmap file
+    bool saveToFile(const std::string& path) const;
+
+    // Builds the vertices of all chunks; with a job system the chunks are split across its threads.
+    // `layers` holds layerCount pointers to width * height ids each. Keeps the current UV table and tile size.
+    void load(const std::uint16_t* const* layers, unsigned int layerCount, unsigned int width, unsigned int height, JobSystem* jobs = nullptr);
+
+    // Replaces the UV table and tile size and rebuilds every chunk
+    void setTileUvs(std::vector<MapTileUv> uvs, Vec2u tileSize, JobSystem* jobs = nullptr);
+
+    // Keeps a solidity grid of `layer` in sync with the tiles: solidIds[id] says whether tile id is solid (ids
+    // past its end aren't). Edits of that layer update the grid too.
+    void setCollision(unsigned int layer, std::vector<bool> solidIds);
+
+    // Map coordinates, without the transform
+    inline const TileGrid& getCollision() const noexcept { return m_Collision; }
+
+    // Changes one tile by patching the four vertices of its quad
+    void setTile(unsigned int x, unsigned int y, std::uint16_t tile, unsigned int layer = 0);
+
+    // Region edits write the tiles first and then rebuild every chunk they touched once, in parallel if a
+    // job system is given. `tiles` holds width * height ids, row by row. The region has to lie within the map.
+    void setTiles(unsigned int left, unsigned int top, unsigned int width, unsigned int height, const std::uint16_t* tiles,
+        unsigned int layer = 0, JobSystem* jobs = nullptr);
+    void fillTiles(unsigned int left, unsigned int top, unsigned int width, unsigned int height, std::uint16_t tile,
+        unsigned int layer = 0, JobSystem* jobs = nullptr);
+
+    std::uint16_t getTile(unsigned int x, unsigned int y, unsigned int layer = 0) const;
+
+    // width * height ids, row by row
+    inline const std::uint16_t* getLayer(unsigned int layer) const noexcept { return m_Layers[layer].data(); }
+    inline unsigned int getLayerCount() const noexcept { return static_cast<unsigned int>(m_Layers.size()); }
+    inline const std::vector<MapTileUv>& getTileUvs() const noexcept { return m_Uvs; }
+    inline Vec2u getTileSize() const noexcept { return m_TileSize; }
+
+    // Needs an active GL context. Stays off if vertex buffers aren't supported (SFML < 2.5 or by the driver).
+    void setVertexBuffers(bool enabled);
+    inline bool usesVertexBuffers() const noexcept { return m_UseVertexBuffers; }
+
+    // Vertex bytes handed to the driver by the last draw: every visible vertex with client-side arrays,
+    // only the changed ones with vertex buffers
+    inline std::size_t getUploadedBytes() const noexcept { return m_UploadedBytes; }
+
+    inline unsigned int getWidth() const noexcept { return m_Width; }
+    inline unsigned int getHeight() const noexcept { return m_Height; }
+    inline std::size_t getChunkCount() const noexcept { return m_Chunks.size(); }
+
+    // Chunks submitted by the last draw
+    inline std::size_t getDrawnChunkCount() const noexcept { return m_DrawnChunks; }
 
 private:
+    struct Chunk
+    {
+        std::vector<sf::Vertex> vertices;
+        std::size_t visibleTiles{0};
+        bool dirty{true};
+
+#ifdef TILEMAP_VERTEX_BUFFER
+        // Uploaded lazily by draw(): everything if !uploaded, otherwise only the patched quads
+        mutable sf::VertexBuffer buffer{sf::Quads, sf::VertexBuffer::Static};
+        mutable bool uploaded{false};
+        mutable bool uploadFailed{false};   // The chunk is drawn from its vertex array from then on
+        mutable std::vector<std::uint32_t> patchedQuads;
+#endif
+    };
+
+    template <typename TGetTile>
+    void editRegion(unsigned int left, unsigned int top, unsigned int width, unsigned int height, unsigned int layer, TGetTile&& getTile,
+        JobSystem* jobs);
+
+    inline Chunk& getChunk(unsigned int layer, unsigned int chunkX, unsigned int chunkY) noexcept
+    {
+        return m_Chunks[(static_cast<std::size_t>(layer) * m_ChunksY + chunkY) * m_ChunksX + chunkX];
+    }
+
+    inline bool isSolid(std::uint16_t tile) const noexcept { return tile < m_SolidIds.size() && m_SolidIds[tile]; }
+
+    void rebuildCollision();
+    void rebuildAllChunks(JobSystem* jobs);
+    void rebuildDirtyChunks(JobSystem* jobs);
+    void buildChunk(Chunk& chunk, unsigned int layer, unsigned int chunkX, unsigned int chunkY);
+    void drawChunk(const Chunk& chunk, sf::RenderTarget& target, const sf::RenderStates& states) const;
     void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
 
 private:
-    sf::Texture m_Tileset;
-    std::vector<sf::Vertex> m_Vertices;
-};
\ No newline at end of file
+    TextureHandle m_Tileset;
+    std::vector<std::vector<std::uint16_t>> m_Layers;
+    std::vector<MapTileUv> m_Uvs;
+    Vec2u m_TileSize{tileWidth, tileHeight};
+    unsigned int m_Width{0}, m_Height{0}, m_ChunksX{0}, m_ChunksY{0};
+    std::vector<Chunk> m_Chunks;
+    TileGrid m_Collision;
+    std::vector<bool> m_SolidIds;
+    unsigned int m_CollisionLayer{0};
+    bool m_UseVertexBuffers{false};
+    mutable std::size_t m_DrawnChunks{0}, m_UploadedBytes{0};
+};